@@ -280,6 +280,7 @@ project.add_static_lib(
     dir="engine",
     sources=engine_sources,
     includepaths=["."],
+    # defines=["THESYSTEM_TRACK_ALLOCATIONS"],
     deps=["sokol", "sokol_gp", "glm", "fmt", "parallel-hashmap",
           "physfs", "pugixml", "rapidjson", "quirrel", "imgui", "tracy",
           "classdb-codegen"
@@ -289,7 +290,8 @@ project.add_static_lib(
 # project.add_executable(
 #     name="engine_tests",
 #     dir="engine",
-#     sources=["tests/test_main.cpp", "tests/test_resource_pool.cpp"],
+#     sources=["tests/test_main.cpp", "tests/test_resource_pool.cpp", "tests/test_arena_allocator.cpp",
+#              "tests/test_radix_sort.cpp"],
 #     includepaths=["."],
 #     deps=["engine", "doctest"],
 #     windows_subsystem="console"
@@ -15,6 +15,7 @@
 #include "squirrel/scriptable_impl.h"
 #include "squirrel/vm.h"
 #include "collision/kinematic_body.h"
+#include "collision/collision_manager.h"
 
 #include "imgui.h"
 #include <sokol_gp.h>
@@ -24,6 +25,23 @@ Ref<T> constructor(sq::Table table) {
     return Engine::instance().get_resources()->new_item<T>(typename T::Options(table));
 }
 
+// Writes colliders into a script array, resizing it in place so scripts can reuse the same array across queries.
+static int write_colliders(sq::Array arr, const std::vector<Ref<Collider>>& colliders) {
+    auto vm = Engine::instance().get_vm()->handle();
+    sq_pushobject(vm, arr.obj);
+    sq_arrayresize(vm, -1, colliders.size());
+    for (int i = 0; i < colliders.size(); i++) {
+        sq_pushinteger(vm, i);
+        sq::push(vm, colliders[i]);
+        sq_rawset(vm, -3);
+    }
+    sq_pop(vm, 1);
+    return colliders.size();
+}
+
+// Query results get copied out of here, so queries don't allocate once it has grown enough
+static std::vector<Ref<Collider>> query_results;
+
 void register_api() {
     auto& engine = Engine::instance();
     auto& vm = *engine.get_vm();
@@ -211,6 +229,48 @@ void register_api() {
         auto cls = vm.add_class<SAnimation, Animation>("ScriptableAnimation", constructor<SAnimation>);
     }
 
+    // Collision
+    {
+        // Colliders have to be registered in the collision manager, so they can't go through constructor<T>
+        auto cls = vm.add_class<Collider, Node>("Collider", +[](sq::Table table) {
+            return Engine::instance().get_collision_manager()->create_collider(Collider::Options(table));
+        });
+        vm.add_method(cls, "set_radius", &Collider::set_radius);
+
+        // Fills out with [collider, point, normal, distance] and returns true if the ray hit something
+        vm.add_func("collision_raycast", +[](vec2 origin, vec2 dir, float max_dist, sq::Array out) {
+            RaycastHit hit;
+            if (!Engine::instance().get_collision_manager()->raycast(origin, dir, max_dist, hit)) {
+                return false;
+            }
+            auto vm = Engine::instance().get_vm()->handle();
+            sq_pushobject(vm, out.obj);
+            sq_arrayresize(vm, -1, 4);
+            sq_pushinteger(vm, 0); sq::push(vm, hit.col); sq_rawset(vm, -3);
+            sq_pushinteger(vm, 1); sq::push(vm, hit.point); sq_rawset(vm, -3);
+            sq_pushinteger(vm, 2); sq::push(vm, hit.normal); sq_rawset(vm, -3);
+            sq_pushinteger(vm, 3); sq::push(vm, hit.distance); sq_rawset(vm, -3);
+            sq_pop(vm, 1);
+            return true;
+        });
+        // The overlap and nearest queries fill out with colliders and return how many there are
+        vm.add_func("collision_overlap_aabb", +[](vec2 min, vec2 max, sq::Array out) {
+            AABB bounds;
+            bounds.min = min;
+            bounds.max = max;
+            Engine::instance().get_collision_manager()->overlap_aabb(bounds, query_results);
+            return write_colliders(out, query_results);
+        });
+        vm.add_func("collision_overlap_circle", +[](vec2 center, float radius, sq::Array out) {
+            Engine::instance().get_collision_manager()->overlap_circle(center, radius, query_results);
+            return write_colliders(out, query_results);
+        });
+        vm.add_func("collision_query_nearest", +[](vec2 pos, int k, float max_dist, sq::Array out) {
+            Engine::instance().get_collision_manager()->query_nearest(pos, k, max_dist, query_results);
+            return write_colliders(out, query_results);
+        });
+    }
+
     // KinematicBody
     {
         auto cls = vm.add_class<KinematicBody, Node>("KinematicBody", constructor<KinematicBody>);
@@ -1,7 +1,27 @@
 #include "collider.h"
 #include "collision_manager.h"
+#include "squirrel/vm.h"
 
 Collider::Options::Options(sq::Table table) {
+    auto vm = Engine::instance().get_vm();
+    pos = vm->get_or_default<vec2>(table, "pos", pos);
+    rot = vm->get_or_default<float>(table, "rot", rot);
+    is_static = vm->get_or_default<bool>(table, "is_static", is_static);
+    layer = vm->get_or_default<uint32_t>(table, "layer", layer);
+    mask = vm->get_or_default<uint32_t>(table, "mask", mask);
+    auto shape = vm->get_or_default<std::string>(table, "shape", "aabb");
+    if (shape == "circle") {
+        type = ColliderType::Circle;
+        circle.radius = vm->get_or_default<float>(table, "radius", 0);
+    }
+    else if (shape == "obb") {
+        type = ColliderType::OBB;
+        obb.extents = vm->get_or_default<vec2>(table, "extents", vec2(0, 0));
+    }
+    else {
+        type = ColliderType::AABB;
+        aabb.extents = vm->get_or_default<vec2>(table, "extents", vec2(0, 0));
+    }
 }
 
 sq::Table Collider::Options::to_sqtable() {
@@ -9,7 +29,11 @@ sq::Table Collider::Options::to_sqtable() {
 }
 
 Collider::Collider(const Options& opt) {
+    _is_collider = true;
     type = opt.type;
+    is_static = opt.is_static;
+    layer = opt.layer;
+    mask = opt.mask;
     switch(type) {
         case ColliderType::Circle: {
             circle.radius = opt.circle.radius;
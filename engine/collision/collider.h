@@ -30,6 +30,11 @@ struct ContactEvent {
     float depth;
 };
 
+// Two colliders interact if either one's mask contains the other's layer.
+inline bool layers_interact(uint32_t layer1, uint32_t mask1, uint32_t layer2, uint32_t mask2) {
+    return ((layer1 & mask2) | (layer2 & mask1)) != 0;
+}
+
 enum class ColliderType {
     AABB, OBB, Circle,
 };
@@ -38,9 +43,14 @@ CLASS(Resource, Node) Collider : public Node {
 public:
     CLASS(OptionFor=Collider) Options {
     public:
-        ColliderType type;
+        ColliderType type = ColliderType::AABB;
         vec2 pos = {0, 0};
         float rot = 0;
+        // Static colliders are expected to never move (ex. tiles).
+        bool is_static = false;
+        // Collision layers this collider is in, and the layers it collides with.
+        uint32_t layer = 1;
+        uint32_t mask = 0xFFFFFFFF;
         union {
             struct {
                 vec2 extents;
@@ -61,6 +71,12 @@ public:
 
     ColliderType type;
     AABB bounds;
+    bool is_static = false;
+    uint32_t layer = 1;
+    uint32_t mask = 0xFFFFFFFF;
+    bool _in_dirty_list = false;
+    // Created or moved since the dense grid got built, so queries can't use its grid cells
+    bool _grid_stale = false;
 
     union {
         struct {
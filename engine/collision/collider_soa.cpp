@@ -0,0 +1,97 @@
+#include "collider_soa.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLLIDER_SOA_SSE2
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+static inline int count_trailing_zeros(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+uint32_t find_overlapping_bounds(const ColliderSoA& cols, uint32_t begin, uint32_t end, const AABB& bounds,
+                                 uint32_t layer, uint32_t mask, uint32_t* out_indices) {
+    const float* min_x = cols.min_x.data();
+    const float* min_y = cols.min_y.data();
+    const float* max_x = cols.max_x.data();
+    const float* max_y = cols.max_y.data();
+    const uint32_t* layers = cols.layers.data();
+    const uint32_t* masks = cols.masks.data();
+
+    uint32_t n = 0;
+    uint32_t i = begin;
+
+#if defined(__AVX2__)
+    __m256 b_min_x = _mm256_set1_ps(bounds.min.x);
+    __m256 b_min_y = _mm256_set1_ps(bounds.min.y);
+    __m256 b_max_x = _mm256_set1_ps(bounds.max.x);
+    __m256 b_max_y = _mm256_set1_ps(bounds.max.y);
+    __m256i b_layer = _mm256_set1_epi32((int)layer);
+    __m256i b_mask = _mm256_set1_epi32((int)mask);
+    __m256i zero = _mm256_setzero_si256();
+    for (; i + 8 <= end; i += 8) {
+        __m256i interact = _mm256_or_si256(
+                _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(layers + i)), b_mask),
+                _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(masks + i)), b_layer));
+        uint32_t layer_rejected = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(interact, zero)));
+        if (layer_rejected == 0xFF) continue;
+
+        __m256 x_overlap = _mm256_and_ps(_mm256_cmp_ps(b_min_x, _mm256_loadu_ps(max_x + i), _CMP_LE_OQ),
+                                         _mm256_cmp_ps(b_max_x, _mm256_loadu_ps(min_x + i), _CMP_GE_OQ));
+        __m256 y_overlap = _mm256_and_ps(_mm256_cmp_ps(b_min_y, _mm256_loadu_ps(max_y + i), _CMP_LE_OQ),
+                                         _mm256_cmp_ps(b_max_y, _mm256_loadu_ps(min_y + i), _CMP_GE_OQ));
+        uint32_t hits = (uint32_t)_mm256_movemask_ps(_mm256_and_ps(x_overlap, y_overlap)) & ~layer_rejected;
+        while (hits) {
+            out_indices[n++] = i + count_trailing_zeros(hits);
+            hits &= hits - 1;
+        }
+    }
+#elif defined(COLLIDER_SOA_SSE2)
+    __m128 b_min_x = _mm_set1_ps(bounds.min.x);
+    __m128 b_min_y = _mm_set1_ps(bounds.min.y);
+    __m128 b_max_x = _mm_set1_ps(bounds.max.x);
+    __m128 b_max_y = _mm_set1_ps(bounds.max.y);
+    __m128i b_layer = _mm_set1_epi32((int)layer);
+    __m128i b_mask = _mm_set1_epi32((int)mask);
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= end; i += 4) {
+        __m128i interact = _mm_or_si128(
+                _mm_and_si128(_mm_loadu_si128((const __m128i*)(layers + i)), b_mask),
+                _mm_and_si128(_mm_loadu_si128((const __m128i*)(masks + i)), b_layer));
+        uint32_t layer_rejected = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(interact, zero)));
+        if (layer_rejected == 0xF) continue;
+
+        __m128 x_overlap = _mm_and_ps(_mm_cmple_ps(b_min_x, _mm_loadu_ps(max_x + i)),
+                                      _mm_cmpge_ps(b_max_x, _mm_loadu_ps(min_x + i)));
+        __m128 y_overlap = _mm_and_ps(_mm_cmple_ps(b_min_y, _mm_loadu_ps(max_y + i)),
+                                      _mm_cmpge_ps(b_max_y, _mm_loadu_ps(min_y + i)));
+        uint32_t hits = (uint32_t)_mm_movemask_ps(_mm_and_ps(x_overlap, y_overlap)) & ~layer_rejected;
+        while (hits) {
+            out_indices[n++] = i + count_trailing_zeros(hits);
+            hits &= hits - 1;
+        }
+    }
+#endif
+
+    // Scalar tail (or everything, if there's no SIMD)
+    for (; i < end; i++) {
+        if (!layers_interact(layer, mask, layers[i], masks[i])) continue;
+        if (bounds.min.x <= max_x[i] && bounds.max.x >= min_x[i] &&
+            bounds.min.y <= max_y[i] && bounds.max.y >= min_y[i]) {
+            out_indices[n++] = i;
+        }
+    }
+    return n;
+}
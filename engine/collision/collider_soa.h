@@ -0,0 +1,57 @@
+#pragma once
+
+#include "collider.h"
+
+#include <vector>
+
+// Packed mirror of collider bounds laid out as a structure of arrays.
+// The broadphase tests against these instead of chasing Collider pointers into the resource pool.
+struct ColliderSoA {
+    std::vector<Ref<Collider>> refs;
+    std::vector<float> min_x, min_y, max_x, max_y;
+    std::vector<uint32_t> layers, masks;
+
+    uint32_t size() const { return refs.size(); }
+
+    void clear() {
+        refs.clear();
+        min_x.clear(); min_y.clear();
+        max_x.clear(); max_y.clear();
+        layers.clear(); masks.clear();
+    }
+
+    void resize(uint32_t n) {
+        refs.resize(n);
+        min_x.resize(n); min_y.resize(n);
+        max_x.resize(n); max_y.resize(n);
+        layers.resize(n); masks.resize(n);
+    }
+
+    void set(uint32_t i, Ref<Collider> ref, const Collider* col) {
+        refs[i] = ref;
+        min_x[i] = col->bounds.min.x; min_y[i] = col->bounds.min.y;
+        max_x[i] = col->bounds.max.x; max_y[i] = col->bounds.max.y;
+        layers[i] = col->layer; masks[i] = col->mask;
+    }
+
+    void push_back(Ref<Collider> ref, const Collider* col) {
+        refs.push_back(ref);
+        min_x.push_back(col->bounds.min.x); min_y.push_back(col->bounds.min.y);
+        max_x.push_back(col->bounds.max.x); max_y.push_back(col->bounds.max.y);
+        layers.push_back(col->layer); masks.push_back(col->mask);
+    }
+
+    AABB get_bounds(uint32_t i) const {
+        AABB bounds;
+        bounds.min = {min_x[i], min_y[i]};
+        bounds.max = {max_x[i], max_y[i]};
+        return bounds;
+    }
+};
+
+// Writes indices in [begin, end) of colliders whose bounds overlap the given bounds (same test as AABB::collides_with),
+// skipping colliders that don't interact with the given layer and mask.
+// Tests 8 (AVX2) or 4 (SSE2) colliders at once when available. out_indices needs room for (end - begin) indices.
+// Returns the number of indices written.
+uint32_t find_overlapping_bounds(const ColliderSoA& cols, uint32_t begin, uint32_t end, const AABB& bounds,
+                                 uint32_t layer, uint32_t mask, uint32_t* out_indices);
@@ -3,13 +3,120 @@
 //
 
 #include "collision_manager.h"
+#include "collider_soa.h"
 
 #include "engine.h"
 #include "resources.h"
+#include "core/thread_pool.h"
+#include "core/alloc_tracker.h"
 
 #include "sokol_gp.h"
 
 #include <glm/gtx/norm.hpp>
+#include <Tracy.hpp>
+
+#include <algorithm>
+#include <cfloat>
+
+// Box described by its center and two half-axis vectors (used for SAT tests between AABBs and OBBs).
+struct BoxShape {
+    vec2 center;
+    vec2 axes[2];
+};
+
+static inline BoxShape get_box_shape(Collider* col) {
+    BoxShape box;
+    if (col->type == ColliderType::AABB) {
+        box.center = col->bounds.center();
+        vec2 extents = 0.5f * col->bounds.size();
+        box.axes[0] = vec2(extents.x, 0);
+        box.axes[1] = vec2(0, extents.y);
+    }
+    else {
+        auto& t = col->_get_global_trans_raw();
+        box.center = t.get_origin();
+        box.axes[0] = t.basis_xform(vec2(col->obb.extents.x, 0));
+        box.axes[1] = t.basis_xform(vec2(0, col->obb.extents.y));
+    }
+    return box;
+}
+
+static inline float project_box_radius(const BoxShape& box, vec2 axis) {
+    return glm::abs(glm::dot(box.axes[0], axis)) + glm::abs(glm::dot(box.axes[1], axis));
+}
+
+// Separating axis test between two boxes, the normal points from box1 to box2.
+static bool box_box_collision(const BoxShape& box1, const BoxShape& box2, ContactEvent& ev) {
+    vec2 d = box2.center - box1.center;
+    float min_overlap = FLT_MAX;
+    vec2 min_axis = vec2(1, 0);
+    const vec2* axes[4] = {&box1.axes[0], &box1.axes[1], &box2.axes[0], &box2.axes[1]};
+    for (int i = 0; i < 4; i++) {
+        float len_sq = glm::length2(*axes[i]);
+        if (len_sq <= 0) continue;
+        vec2 axis = *axes[i] / glm::sqrt(len_sq);
+        float dist = glm::dot(d, axis);
+        float overlap = project_box_radius(box1, axis) + project_box_radius(box2, axis) - glm::abs(dist);
+        if (overlap <= 0) {
+            return false;
+        }
+        if (overlap < min_overlap) {
+            min_overlap = overlap;
+            min_axis = dist < 0 ? -axis : axis;
+        }
+    }
+
+    // Use the deepest corner of box2 along the normal as the contact point
+    vec2 corner = box2.center;
+    corner -= glm::dot(box2.axes[0], min_axis) > 0 ? box2.axes[0] : -box2.axes[0];
+    corner -= glm::dot(box2.axes[1], min_axis) > 0 ? box2.axes[1] : -box2.axes[1];
+    ev.point = corner + 0.5f * min_overlap * min_axis;
+    ev.normal = min_axis;
+    ev.depth = min_overlap;
+    return true;
+}
+
+// Closest point test between a box and a circle, the normal points from the box to the circle.
+static bool box_circle_collision(const BoxShape& box, vec2 circle_center, float radius, ContactEvent& ev) {
+    float half_extents[2];
+    vec2 axis_dirs[2];
+    for (int i = 0; i < 2; i++) {
+        half_extents[i] = glm::length(box.axes[i]);
+        axis_dirs[i] = half_extents[i] > 0 ? box.axes[i] / half_extents[i] : vec2(1 - i, i);
+    }
+    vec2 d = circle_center - box.center;
+    vec2 local = vec2(glm::dot(d, axis_dirs[0]), glm::dot(d, axis_dirs[1]));
+    vec2 clamped = glm::clamp(local, vec2(-half_extents[0], -half_extents[1]), vec2(half_extents[0], half_extents[1]));
+
+    if (clamped != local) {
+        // Circle center is outside of the box
+        vec2 closest = box.center + clamped.x * axis_dirs[0] + clamped.y * axis_dirs[1];
+        vec2 diff = circle_center - closest;
+        float dist_sq = glm::length2(diff);
+        if (dist_sq > radius * radius) {
+            return false;
+        }
+        float dist = glm::sqrt(dist_sq);
+        ev.point = closest;
+        ev.normal = dist > 0 ? diff / dist : axis_dirs[0];
+        ev.depth = radius - dist;
+    }
+    else {
+        // Circle center is inside of the box, push out through the nearest face
+        float dx = half_extents[0] - glm::abs(local.x);
+        float dy = half_extents[1] - glm::abs(local.y);
+        if (dx <= dy) {
+            ev.normal = local.x < 0 ? -axis_dirs[0] : axis_dirs[0];
+            ev.depth = dx + radius;
+        }
+        else {
+            ev.normal = local.y < 0 ? -axis_dirs[1] : axis_dirs[1];
+            ev.depth = dy + radius;
+        }
+        ev.point = circle_center;
+    }
+    return true;
+}
 
 bool aabb_aabb_collision(Collider* col1, Collider* col2, ContactEvent& ev) {
     AABB isect;
@@ -36,19 +143,21 @@ bool aabb_aabb_collision(Collider* col1, Collider* col2, ContactEvent& ev) {
 }
 
 bool aabb_obb_collision(Collider* col1, Collider* col2, ContactEvent& ev) {
-    return false;
+    return box_box_collision(get_box_shape(col1), get_box_shape(col2), ev);
 }
 
 bool aabb_circle_collision(Collider* col1, Collider* col2, ContactEvent& ev) {
-    return false;
+    return box_circle_collision(get_box_shape(col1), col2->_get_global_trans_raw().get_origin(),
+                                col2->circle.radius, ev);
 }
 
 bool obb_obb_collision(Collider* col1, Collider* col2, ContactEvent& ev) {
-    return false;
+    return box_box_collision(get_box_shape(col1), get_box_shape(col2), ev);
 }
 
 bool obb_circle_collision(Collider* col1, Collider* col2, ContactEvent& ev) {
-    return false;
+    return box_circle_collision(get_box_shape(col1), col2->_get_global_trans_raw().get_origin(),
+                                col2->circle.radius, ev);
 }
 
 bool circle_circle_collision(Collider* col1, Collider* col2, ContactEvent& ev) {
@@ -62,8 +171,8 @@ bool circle_circle_collision(Collider* col1, Collider* col2, ContactEvent& ev) {
     if (p_len_sq <= r_tot * r_tot) {
         float p_len = glm::sqrt(p_len_sq);
         ev.point = 0.5f * (p1 + p2);
-        ev.normal = p / p_len;
-        ev.depth = p_len - r_tot;
+        ev.normal = p_len > 0 ? p / p_len : vec2(1, 0);
+        ev.depth = r_tot - p_len;
         return true;
     }
     else {
@@ -77,99 +186,676 @@ bool (*dispatch_func_matrix[3][3])(Collider*, Collider*, ContactEvent&) = {
         {nullptr,             nullptr,            circle_circle_collision}
 };
 
+// Index of each shape pair into NarrowPhaseScratch::buckets
+static constexpr int shape_pair_index[3][3] = {
+        {0, 1, 2},
+        {1, 3, 4},
+        {2, 4, 5}
+};
+
+template <bool (*Fun)(Collider*, Collider*, ContactEvent&)>
+static void run_contact_bucket(std::vector<ContactCandidate>& bucket,
+                               std::vector<ContactEvent>& out_contact_events, CollisionStats& out_stats) {
+    for (auto& pair : bucket) {
+        ContactEvent ev;
+        if (Fun(pair.col1, pair.col2, ev)) {
+            ev.col1 = pair.col1_ref;
+            ev.col2 = pair.col2_ref;
+            out_contact_events.push_back(ev);
+            out_stats.contacts++;
+        }
+    }
+    bucket.clear();
+}
+
+static inline void add_contact_candidate(NarrowPhaseScratch& scratch, Ref<Collider> col1_ref, Collider* col1,
+                                         Ref<Collider> col2_ref, Collider* col2) {
+    if ((int)col1->type > (int)col2->type) {
+        std::swap(col1, col2);
+        std::swap(col1_ref, col2_ref);
+    }
+    scratch.buckets[shape_pair_index[(int)col1->type][(int)col2->type]].push_back({col1_ref, col2_ref, col1, col2});
+}
+
+// Runs the narrow phase on a pair (the collider with the lower shape type always ends up in ev.col1).
+static bool collide_pair(Ref<Collider> col1_ref, Collider* col1, Ref<Collider> col2_ref, Collider* col2,
+                         ContactEvent& ev) {
+    if ((int)col1->type > (int)col2->type) {
+        std::swap(col1, col2);
+        std::swap(col1_ref, col2_ref);
+    }
+    auto fun = dispatch_func_matrix[(int)col1->type][(int)col2->type];
+    if (fun(col1, col2, ev)) {
+        ev.col1 = col1_ref;
+        ev.col2 = col2_ref;
+        return true;
+    }
+    return false;
+}
+
+// Time of impact of box1 moving along dx against a fixed box2 (swept AABB test).
+// Returns false if they don't meet within the motion, or if they already overlap at the start.
+static bool sweep_aabb(const AABB& box1, vec2 dx, const AABB& box2, float& out_toi, vec2& out_normal) {
+    float t_entry = -FLT_MAX, t_exit = FLT_MAX;
+    int entry_axis = -1;
+    for (int i = 0; i < 2; i++) {
+        float entry, exit;
+        if (dx[i] > 0) {
+            entry = (box2.min[i] - box1.max[i]) / dx[i];
+            exit = (box2.max[i] - box1.min[i]) / dx[i];
+        }
+        else if (dx[i] < 0) {
+            entry = (box2.max[i] - box1.min[i]) / dx[i];
+            exit = (box2.min[i] - box1.max[i]) / dx[i];
+        }
+        else {
+            // Not moving along this axis, so they have to overlap on it all the time
+            if (box1.max[i] <= box2.min[i] || box1.min[i] >= box2.max[i]) return false;
+            continue;
+        }
+        if (entry > t_entry) {
+            t_entry = entry;
+            entry_axis = i;
+        }
+        t_exit = glm::min(t_exit, exit);
+    }
+    // Starting overlaps are left to the contact solver
+    if (entry_axis < 0 || t_entry < 0 || t_entry > 1 || t_entry >= t_exit) return false;
+
+    out_toi = t_entry;
+    out_normal = vec2(0, 0);
+    out_normal[entry_axis] = dx[entry_axis] > 0 ? -1.0f : 1.0f;
+    return true;
+}
+
+// Ray against a box (slab test in the box's local frame). dir should be normalized.
+static bool ray_box_intersect(vec2 origin, vec2 dir, const BoxShape& box, float& out_t, vec2& out_normal) {
+    float t_entry = -FLT_MAX, t_exit = FLT_MAX;
+    vec2 entry_normal = {0, 0};
+    vec2 d = origin - box.center;
+    for (int i = 0; i < 2; i++) {
+        float half_extent = glm::length(box.axes[i]);
+        vec2 axis_dir = half_extent > 0 ? box.axes[i] / half_extent : vec2(1 - i, i);
+        float o = glm::dot(d, axis_dir);
+        float v = glm::dot(dir, axis_dir);
+        if (v == 0) {
+            if (o < -half_extent || o > half_extent) return false;
+            continue;
+        }
+        float t1 = (-half_extent - o) / v;
+        float t2 = (half_extent - o) / v;
+        if (t1 > t2) std::swap(t1, t2);
+        if (t1 > t_entry) {
+            t_entry = t1;
+            entry_normal = v > 0 ? -axis_dir : axis_dir;
+        }
+        t_exit = glm::min(t_exit, t2);
+    }
+    if (t_entry < 0 || t_entry > t_exit) return false;
+    out_t = t_entry;
+    out_normal = entry_normal;
+    return true;
+}
+
+// Ray against a circle. dir should be normalized.
+static bool ray_circle_intersect(vec2 origin, vec2 dir, vec2 center, float radius, float& out_t, vec2& out_normal) {
+    vec2 m = origin - center;
+    float b = glm::dot(m, dir);
+    float c = glm::dot(m, m) - radius * radius;
+    if (c <= 0 || b > 0) return false;
+    float disc = b * b - c;
+    if (disc < 0) return false;
+    out_t = -b - glm::sqrt(disc);
+    out_normal = radius > 0 ? (origin + out_t * dir - center) / radius : -dir;
+    return true;
+}
+
+static bool raycast_collider(vec2 origin, vec2 dir, Collider* col, float& out_t, vec2& out_normal) {
+    if (col->type == ColliderType::Circle) {
+        return ray_circle_intersect(origin, dir, col->_get_global_trans_raw().get_origin(), col->circle.radius,
+                                    out_t, out_normal);
+    }
+    return ray_box_intersect(origin, dir, get_box_shape(col), out_t, out_normal);
+}
+
+// Distance from a point to the shape of a collider (0 if the point is inside).
+static float point_distance(vec2 pos, Collider* col) {
+    if (col->type == ColliderType::Circle) {
+        vec2 center = col->_get_global_trans_raw().get_origin();
+        return glm::max(0.0f, glm::length(pos - center) - col->circle.radius);
+    }
+    auto box = get_box_shape(col);
+    vec2 d = pos - box.center;
+    vec2 outside;
+    for (int i = 0; i < 2; i++) {
+        float half_extent = glm::length(box.axes[i]);
+        vec2 axis_dir = half_extent > 0 ? box.axes[i] / half_extent : vec2(1 - i, i);
+        outside[i] = glm::max(0.0f, glm::abs(glm::dot(d, axis_dir)) - half_extent);
+    }
+    return glm::length(outside);
+}
+
+static AABB compute_bounds(Collider* col) {
+    AABB bounds;
+    auto t = col->get_global_trans();
+    auto center = t.get_origin();
+    switch (col->type) {
+        case ColliderType::AABB: {
+            bounds.min = center - col->aabb.extents;
+            bounds.max = center + col->aabb.extents;
+        } break;
+        case ColliderType::OBB: {
+            auto u = t.basis_xform(vec2(col->obb.extents.x, 0));
+            auto v = t.basis_xform(vec2(0, col->obb.extents.y));
+            vec2 max_extents = glm::abs(u) + glm::abs(v);
+            bounds.min = center - max_extents;
+            bounds.max = center + max_extents;
+        } break;
+        case ColliderType::Circle: {
+            bounds.min = center - col->circle.radius;
+            bounds.max = center + col->circle.radius;
+        } break;
+    }
+    return bounds;
+}
+
 Ref<Collider> CollisionManager::create_collider(const Collider::Options& opt) {
     auto res = Engine::instance().get_resources();
     auto col_ref = res->new_item<Collider>(opt);
-    add_collider(col_ref);
+    auto col = col_ref.get();
+    col->bounds = compute_bounds(col);
+    if (col->is_static) {
+        // Static colliders usually get parented right after creation, so index them lazily
+        static_colliders.push_back(col_ref);
+        static_index_dirty = true;
+    }
+    else {
+        dynamic_colliders.push_back(col_ref);
+        add_collider(col_ref);
+    }
     return col_ref;
 }
 
+template <class Fun>
+void CollisionManager::foreach_in_cell(ivec2 ipos, Fun&& fun) {
+    if (use_dense_grid) {
+        auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+        auto span = dynamic_grid.get_cell(ipos);
+        for (uint32_t k = span.begin; k < span.begin + span.count; k++) {
+            auto col_ref = span.cols->refs[k];
+            // Skip released colliders, and ones whose grid cells are out of date (they're visited below)
+            auto col = pool.try_get(col_ref);
+            if (!col || col->_grid_stale) continue;
+            fun(col_ref);
+        }
+        for (auto col_ref : grid_stale_colliders) {
+            auto col = pool.try_get(col_ref);
+            if (!col) continue;
+            ivec2 imin = get_cell(col->bounds.min);
+            ivec2 imax = get_cell(col->bounds.max);
+            if (ipos.x >= imin.x && ipos.x <= imax.x && ipos.y >= imin.y && ipos.y <= imax.y) {
+                fun(col_ref);
+            }
+        }
+    }
+    else {
+        auto it = spatial_hash.find(ipos);
+        if (it != spatial_hash.end()) {
+            for (auto col_ref : it->second.colliders) {
+                fun(col_ref);
+            }
+        }
+    }
+    auto static_span = get_static_cell(ipos);
+    for (uint32_t k = static_span.begin; k < static_span.begin + static_span.count; k++) {
+        fun(static_span.cols->refs[k]);
+    }
+}
+
+void CollisionManager::notify_transform(Ref<Collider> col_ref) {
+    auto col = col_ref.get_unsafe();
+    if (col->_in_dirty_list) return;
+    col->_in_dirty_list = true;
+    dirty_colliders.push_back(col_ref);
+}
+
+void CollisionManager::set_bounds(const AABB& world_bounds) {
+    if (use_dense_grid) {
+        grid_bounds.min = glm::min(grid_bounds.min, world_bounds.min);
+        grid_bounds.max = glm::max(grid_bounds.max, world_bounds.max);
+    }
+    else {
+        grid_bounds = world_bounds;
+    }
+    ivec2 imin = ivec2(grid_bounds.min / cell_size);
+    ivec2 imax = ivec2(grid_bounds.max / cell_size);
+    dynamic_grid.origin = static_grid.origin = imin;
+    dynamic_grid.size = static_grid.size = imax - imin + 1;
+    int n_cells = dynamic_grid.size.x * dynamic_grid.size.y;
+    for (auto grid : {&dynamic_grid, &static_grid}) {
+        grid->offsets.assign(n_cells + 1, 0);
+        grid->cols.clear();
+    }
+    use_dense_grid = true;
+
+    // The grids get rebuilt from the collider lists, until then queries find the dynamic colliders as stale ones
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+    for (auto col_ref : dynamic_colliders) {
+        if (auto col = pool.try_get(col_ref)) {
+            mark_grid_stale(col_ref, col);
+        }
+    }
+    spatial_hash.clear();
+    static_index.clear();
+    static_index_dirty = true;
+}
+
+void CollisionManager::clear_bounds() {
+    if (!use_dense_grid) return;
+    use_dense_grid = false;
+
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+    for (auto col_ref : grid_stale_colliders) {
+        if (auto col = pool.try_get(col_ref)) {
+            col->_grid_stale = false;
+        }
+    }
+    grid_stale_colliders.clear();
+    for (auto grid : {&dynamic_grid, &static_grid}) {
+        grid->origin = grid->size = ivec2(0, 0);
+        grid->offsets.clear();
+        grid->cols.clear();
+    }
+
+    // Put the remaining dynamic colliders back into the spatial hash
+    spatial_hash.clear();
+    occupied_min = static_occupied_min = ivec2(INT_MAX);
+    occupied_max = static_occupied_max = ivec2(INT_MIN);
+    for (auto col_ref : dynamic_colliders) {
+        if (pool.is_valid(col_ref)) {
+            add_collider(col_ref);
+        }
+    }
+    static_index_dirty = true;
+}
+
 void CollisionManager::update() {
-    auto res = Engine::instance().get_resources();
+    ZoneScoped
+    AllocScope alloc_scope(AllocTag::Collision);
 
-    // Update transforms and AABB bounds
-    res->foreach_ref<Collider>([this](Ref<Collider> col_ref, Collider& col) {
-        col.contact_events.clear();
-        update_collider(col_ref);
-    });
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+
+    // Only colliders that got contacts last frame have anything to clear
+    for (auto& ev : contact_events) {
+        if (auto col = pool.try_get(ev.col1)) col->contact_events.clear();
+        if (auto col = pool.try_get(ev.col2)) col->contact_events.clear();
+    }
+
+    // Update transforms and AABB bounds of colliders that moved
+    for (auto col_ref : dirty_colliders) {
+        auto col = pool.try_get(col_ref);
+        if (!col) continue;
+        col->_in_dirty_list = false;
+        if (col->is_static) {
+            static_index_dirty = true;
+        }
+        else {
+            update_collider(col_ref);
+        }
+    }
+    TracyPlot("Collision Dirty Colliders", (int64_t)dirty_colliders.size());
+    dirty_colliders.clear();
+
+    if (static_index_dirty) {
+        rebuild_static_index();
+    }
+
+    bool has_released = false;
+    for (int i = 0; i < dynamic_colliders.size(); ) {
+        if (!pool.is_valid(dynamic_colliders[i])) {
+            dynamic_colliders[i] = dynamic_colliders.back();
+            dynamic_colliders.pop_back();
+            has_released = true;
+            continue;
+        }
+        i++;
+    }
+    if (has_released && !use_dense_grid) {
+        // Released colliders can't be read anymore to find their cells, so sweep them out of every cell
+        ZoneScopedN("Remove Released Colliders")
+        for (auto& [ipos, entry] : spatial_hash) {
+            auto& colliders = entry.colliders;
+            colliders.erase(std::remove_if(colliders.begin(), colliders.end(), [&](Ref<Collider> col_ref) {
+                return !pool.is_valid(col_ref);
+            }), colliders.end());
+        }
+    }
+
+    // Gather cells that can have contacts in them
+    active_cells.clear();
+    if (use_dense_grid) {
+        build_dense_grid(dynamic_grid, dynamic_colliders);
+        for (auto col_ref : grid_stale_colliders) {
+            if (auto col = pool.try_get(col_ref)) {
+                col->_grid_stale = false;
+            }
+        }
+        grid_stale_colliders.clear();
+        for (int y = 0; y < dynamic_grid.size.y; y++) {
+            for (int x = 0; x < dynamic_grid.size.x; x++) {
+                ivec2 ipos = dynamic_grid.origin + ivec2(x, y);
+                auto span = dynamic_grid.get_cell(ipos);
+                if (span.count >= 2) {
+                    active_cells.push_back({ipos, span});
+                }
+            }
+        }
+    }
+    else {
+        // Pack active cells of the spatial hash, so the narrow phase always reads contiguous bounds
+        active_cols.clear();
+        occupied_min = static_occupied_min;
+        occupied_max = static_occupied_max;
+        for (auto& [ipos, entry] : spatial_hash) {
+            if (!entry.colliders.empty()) {
+                grow_occupied_cells(ipos, ipos);
+            }
+            if (entry.colliders.size() >= 2) {
+                uint32_t begin = active_cols.size();
+                for (auto col_ref : entry.colliders) {
+                    active_cols.push_back(col_ref, col_ref.get());
+                }
+                active_cells.push_back({ipos, {&active_cols, begin, (uint32_t)entry.colliders.size()}});
+            }
+        }
+    }
 
     // Find contact events
     contact_events.clear();
-    for (auto& [ipos, entry] : spatial_hash) {
-        int n_cols = entry.colliders.size();
-        for (int i = 0; i < n_cols; i++) {
-            auto col_ref = entry.colliders[i];
-            auto col = col_ref.get();
-            for (int j = i+1; j < n_cols; j++) {
-                auto col1 = col;
-                auto col1_ref = col_ref;
-                auto col2_ref = entry.colliders[j];
-                auto col2 = col2_ref.get();
-                if (!col1->bounds.collides_with(col2->bounds)) {
-                    continue;
+    stats = {};
+    int n_items = active_cells.size();
+    bool has_static = use_dense_grid ? static_grid.cols.size() > 0 : static_index.cols.size() > 0;
+    if (has_static) {
+        n_items += dynamic_colliders.size();
+    }
+    auto thread_pool = Engine::instance().get_thread_pool();
+    thread_scratch.resize(thread_pool ? thread_pool->num_threads() : 1);
+    int n_chunks = (n_items + items_per_chunk - 1) / items_per_chunk;
+    if (!thread_pool || thread_pool->num_threads() == 1 || n_items < min_items_for_parallel) {
+        // Still go chunk by chunk, so contacts come out in the same order as the parallel path
+        for (int chunk = 0; chunk < n_chunks; chunk++) {
+            int item_begin = chunk * items_per_chunk;
+            int item_end = std::min(item_begin + items_per_chunk, n_items);
+            find_contacts(item_begin, item_end, thread_scratch[0], contact_events, stats);
+        }
+    }
+    else {
+        ZoneScopedN("Parallel Narrow Phase")
+        thread_contact_events.resize(thread_pool->num_threads());
+        for (auto& events : thread_contact_events) {
+            events.clear();
+        }
+        thread_stats.assign(thread_pool->num_threads(), CollisionStats());
+        contact_chunks.resize(n_chunks);
+        thread_pool->parallel_for(n_chunks, [&](int chunk, int thread) {
+            AllocScope alloc_scope(AllocTag::Collision);
+            auto& events = thread_contact_events[thread];
+            uint32_t begin = events.size();
+            int item_begin = chunk * items_per_chunk;
+            int item_end = std::min(item_begin + items_per_chunk, n_items);
+            find_contacts(item_begin, item_end, thread_scratch[thread], events, thread_stats[thread]);
+            contact_chunks[chunk] = {thread, begin, (uint32_t)events.size()};
+        });
+
+        // Merge in chunk order, so the result is the same as running serially
+        for (auto& chunk : contact_chunks) {
+            auto& events = thread_contact_events[chunk.thread];
+            contact_events.insert(contact_events.end(), events.begin() + chunk.begin, events.begin() + chunk.end);
+        }
+        for (auto& s : thread_stats) {
+            stats += s;
+        }
+    }
+
+    TracyPlot("Collision Pair Tests", (int64_t)stats.pair_tests);
+    TracyPlot("Collision Duplicate Pairs", (int64_t)stats.duplicate_pairs);
+    TracyPlot("Collision Contacts", (int64_t)stats.contacts);
+
+    for (auto& ev : contact_events) {
+        ev.col1.get()->contact_events.push_back(ev);
+        ev.col2.get()->contact_events.push_back(ev);
+    }
+}
+
+void CollisionManager::find_contacts(int item_begin, int item_end, NarrowPhaseScratch& scratch,
+                                     std::vector<ContactEvent>& out_contact_events,
+                                     CollisionStats& out_stats) {
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+    auto& candidates = scratch.candidates;
+    int n_cells = active_cells.size();
+    for (int item = item_begin; item < item_end; item++) {
+        if (item < n_cells) {
+            // Dynamic vs dynamic colliders in one cell
+            auto [ipos, span] = active_cells[item];
+            auto& cols = *span.cols;
+            uint32_t end = span.begin + span.count;
+            candidates.resize(span.count);
+            for (uint32_t i = span.begin; i < end; i++) {
+                AABB bounds1 = cols.get_bounds(i);
+                uint32_t n_candidates = find_overlapping_bounds(cols, i + 1, end, bounds1,
+                                                                cols.layers[i], cols.masks[i], candidates.data());
+                if (n_candidates == 0) continue;
+
+                auto col1_ref = cols.refs[i];
+                auto col1 = col1_ref.get();
+                for (uint32_t c = 0; c < n_candidates; c++) {
+                    uint32_t j = candidates[c];
+                    if (get_owner_cell(bounds1, cols.get_bounds(j)) != ipos) {
+                        out_stats.duplicate_pairs++;
+                        continue;
+                    }
+                    auto col2_ref = cols.refs[j];
+                    add_contact_candidate(scratch, col1_ref, col1, col2_ref, col2_ref.get());
+                    out_stats.pair_tests++;
                 }
-                if ((int)col1->type > (int)col2->type) {
-                    std::swap(col1, col2);
-                    std::swap(col1_ref, col2_ref);
+            }
+        }
+        else {
+            // One dynamic collider vs the static index
+            auto col1_ref = dynamic_colliders[item - n_cells];
+            auto col1 = col1_ref.get();
+            AABB bounds1 = col1->bounds;
+            ivec2 imin = get_cell(bounds1.min);
+            ivec2 imax = get_cell(bounds1.max);
+            for (int x = imin.x; x <= imax.x; x++) {
+                for (int y = imin.y; y <= imax.y; y++) {
+                    auto span = get_static_cell(ivec2(x, y));
+                    if (span.count == 0) continue;
+
+                    auto& cols = *span.cols;
+                    candidates.resize(span.count);
+                    uint32_t n_candidates = find_overlapping_bounds(cols, span.begin, span.begin + span.count, bounds1,
+                                                                    col1->layer, col1->mask, candidates.data());
+                    for (uint32_t c = 0; c < n_candidates; c++) {
+                        uint32_t j = candidates[c];
+                        if (get_owner_cell(bounds1, cols.get_bounds(j)) != ivec2(x, y)) {
+                            out_stats.duplicate_pairs++;
+                            continue;
+                        }
+                        // Released static colliders stay in the index until it gets rebuilt
+                        auto col2_ref = cols.refs[j];
+                        auto col2 = pool.try_get(col2_ref);
+                        if (!col2) continue;
+                        add_contact_candidate(scratch, col1_ref, col1, col2_ref, col2);
+                        out_stats.pair_tests++;
+                    }
                 }
-                auto fun = dispatch_func_matrix[(int)col1->type][(int)col2->type];
-                ContactEvent ev;
-                if (fun(col1, col2, ev)) {
-                    ev.col1 = col1_ref;
-                    ev.col2 = col2_ref;
-                    contact_events.push_back(ev);
+            }
+        }
+    }
 
-                    col1->contact_events.push_back(ev);
-                    col2->contact_events.push_back(ev);
+    // Run the narrow phase one shape pair at a time
+    auto& buckets = scratch.buckets;
+    run_contact_bucket<aabb_aabb_collision>(buckets[0], out_contact_events, out_stats);
+    run_contact_bucket<aabb_obb_collision>(buckets[1], out_contact_events, out_stats);
+    run_contact_bucket<aabb_circle_collision>(buckets[2], out_contact_events, out_stats);
+    run_contact_bucket<obb_obb_collision>(buckets[3], out_contact_events, out_stats);
+    run_contact_bucket<obb_circle_collision>(buckets[4], out_contact_events, out_stats);
+    run_contact_bucket<circle_circle_collision>(buckets[5], out_contact_events, out_stats);
+}
+
+void CollisionManager::rebuild_static_index() {
+    ZoneScoped
+
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+
+    std::vector<std::pair<ivec2, Ref<Collider>>> cell_entries;
+    static_occupied_min = ivec2(INT_MAX);
+    static_occupied_max = ivec2(INT_MIN);
+    for (int i = 0; i < static_colliders.size(); ) {
+        auto col_ref = static_colliders[i];
+        if (!pool.is_valid(col_ref)) {
+            static_colliders[i] = static_colliders.back();
+            static_colliders.pop_back();
+            continue;
+        }
+        auto col = col_ref.get();
+        col->bounds = compute_bounds(col);
+        if (!use_dense_grid) {
+            ivec2 imin = get_cell(col->bounds.min);
+            ivec2 imax = get_cell(col->bounds.max);
+            static_occupied_min = glm::min(static_occupied_min, imin);
+            static_occupied_max = glm::max(static_occupied_max, imax);
+            for (int x = imin.x; x <= imax.x; x++) {
+                for (int y = imin.y; y <= imax.y; y++) {
+                    cell_entries.push_back({ivec2(x, y), col_ref});
                 }
             }
         }
+        i++;
+    }
+
+    static_index_dirty = false;
+    if (use_dense_grid) {
+        build_dense_grid(static_grid, static_colliders);
+        return;
+    }
+
+    grow_occupied_cells(static_occupied_min, static_occupied_max);
+    std::stable_sort(cell_entries.begin(), cell_entries.end(), [](const auto& a, const auto& b) {
+        return a.first.x < b.first.x || (a.first.x == b.first.x && a.first.y < b.first.y);
+    });
+
+    static_index.clear();
+    static_index.cols.resize(cell_entries.size());
+    StaticCellRange* range = nullptr;
+    for (int i = 0; i < cell_entries.size(); i++) {
+        if (i == 0 || cell_entries[i].first != cell_entries[i-1].first) {
+            auto [it, inserted] = static_index.cells.insert({cell_entries[i].first, {(uint32_t)i, 0}});
+            range = &it->second;
+        }
+        auto col_ref = cell_entries[i].second;
+        static_index.cols.set(i, col_ref, col_ref.get());
+        range->count++;
     }
 }
 
+void CollisionManager::build_dense_grid(DenseGrid& grid, const std::vector<Ref<Collider>>& colliders) {
+    ZoneScoped
+
+    int n_cells = grid.size.x * grid.size.y;
+
+    // Count colliders in each cell
+    grid.offsets.assign(n_cells + 1, 0);
+    for (auto col_ref : colliders) {
+        auto col = col_ref.get();
+        ivec2 imin = get_cell(col->bounds.min);
+        ivec2 imax = get_cell(col->bounds.max);
+        for (int y = imin.y; y <= imax.y; y++) {
+            for (int x = imin.x; x <= imax.x; x++) {
+                grid.offsets[grid.cell_index(ivec2(x, y)) + 1]++;
+            }
+        }
+    }
+
+    // Prefix sum to get the start of each cell
+    for (int i = 0; i < n_cells; i++) {
+        grid.offsets[i + 1] += grid.offsets[i];
+    }
+
+    // Scatter colliders into their cells
+    grid.cols.resize(grid.offsets[n_cells]);
+    grid_cursors.assign(grid.offsets.begin(), grid.offsets.end() - 1);
+    for (auto col_ref : colliders) {
+        auto col = col_ref.get();
+        ivec2 imin = get_cell(col->bounds.min);
+        ivec2 imax = get_cell(col->bounds.max);
+        for (int y = imin.y; y <= imax.y; y++) {
+            for (int x = imin.x; x <= imax.x; x++) {
+                grid.cols.set(grid_cursors[grid.cell_index(ivec2(x, y))]++, col_ref, col);
+            }
+        }
+    }
+}
+
+CellSpan CollisionManager::get_static_cell(ivec2 ipos) const {
+    if (use_dense_grid) {
+        return static_grid.get_cell(ipos);
+    }
+    auto it = static_index.cells.find(ipos);
+    if (it == static_index.cells.end()) return {};
+    auto range = it->second;
+    return {&static_index.cols, range.begin, range.count};
+}
+
 void CollisionManager::update_partial(
         const std::vector<Ref<Collider>>& colliders,
-        std::vector<ContactEvent>& out_contact_events) {
+        arena_vector<ContactEvent>& out_contact_events) {
+    AllocScope alloc_scope(AllocTag::Collision);
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+
+    if (static_index_dirty) {
+        rebuild_static_index();
+    }
 
     for (auto col_ref : colliders) {
+        // Static colliders only live in the static index (and shouldn't move anyway)
+        if (col_ref.get()->is_static) continue;
         update_collider(col_ref);
     }
     for (auto col_ref : colliders) {
         auto col = col_ref.get();
-        ivec2 imin = col->bounds.min / cell_size;
-        ivec2 imax = col->bounds.max / cell_size;
-        for (int x = imin.x; x <= imax.x; x++) {
-            for (int y = imin.y; y <= imax.y; y++) {
-                auto& entry = spatial_hash.at(ivec2(x, y));
-                auto col1 = col;
-                auto col1_ref = col_ref;
-                for (auto col2_ref : entry.colliders) {
-                    if (col1_ref == col2_ref) continue;
+        auto test_collider = [&](Ref<Collider> col2_ref, ivec2 ipos) {
+            if (col_ref == col2_ref) return;
 
-                    auto col2 = col2_ref.get();
-                    if (!col1->bounds.collides_with(col2->bounds)) {
-                        continue;
-                    }
-                    if ((int)col1->type > (int)col2->type) {
-                        std::swap(col1, col2);
-                        std::swap(col1_ref, col2_ref);
-                    }
-                    auto fun = dispatch_func_matrix[(int)col1->type][(int)col2->type];
-                    ContactEvent ev;
-                    if (fun(col1, col2, ev)) {
-                        // Always make col1 be the requested collider reference
-                        if (col1 == col) {
-                            ev.col1 = col1_ref;
-                            ev.col2 = col2_ref;
-                        }
-                        else {
-                            ev.col1 = col2_ref;
-                            ev.col2 = col1_ref;
-                            ev.normal = -ev.normal; // flip normals
-                        }
-                        out_contact_events.push_back(ev);
-                    }
+            // Colliders released since the last update() can still be in the cells
+            auto col2 = pool.try_get(col2_ref);
+            if (!col2) return;
+            if (!layers_interact(col->layer, col->mask, col2->layer, col2->mask)) return;
+            if (!col->bounds.collides_with(col2->bounds)) {
+                return;
+            }
+            if (get_owner_cell(col->bounds, col2->bounds) != ipos) {
+                return;
+            }
+            ContactEvent ev;
+            if (collide_pair(col_ref, col, col2_ref, col2, ev)) {
+                // Always make col1 be the requested collider reference
+                if (ev.col1 != col_ref) {
+                    std::swap(ev.col1, ev.col2);
+                    ev.normal = -ev.normal; // flip normals
                 }
+                out_contact_events.push_back(ev);
+            }
+        };
+        ivec2 imin = get_cell(col->bounds.min);
+        ivec2 imax = get_cell(col->bounds.max);
+        for (int x = imin.x; x <= imax.x; x++) {
+            for (int y = imin.y; y <= imax.y; y++) {
+                ivec2 ipos = ivec2(x, y);
+                foreach_in_cell(ipos, [&](Ref<Collider> col2_ref) {
+                    test_collider(col2_ref, ipos);
+                });
             }
         }
     }
@@ -177,8 +863,15 @@ void CollisionManager::update_partial(
 
 void CollisionManager::add_collider(Ref<Collider> col_ref) {
     auto col = col_ref.get();
-    ivec2 imin = col->bounds.min / cell_size;
-    ivec2 imax = col->bounds.max / cell_size;
+    // Dense grids are rebuilt every update() from the collider list
+    if (use_dense_grid) {
+        mark_grid_stale(col_ref, col);
+        return;
+    }
+
+    ivec2 imin = get_cell(col->bounds.min);
+    ivec2 imax = get_cell(col->bounds.max);
+    grow_occupied_cells(imin, imax);
     for (int x = imin.x; x <= imax.x; x++) {
         for (int y = imin.y; y <= imax.y; y++) {
             auto it = spatial_hash.find(ivec2(x, y));
@@ -196,8 +889,8 @@ void CollisionManager::add_collider(Ref<Collider> col_ref) {
 
 void CollisionManager::remove_collider(Ref<Collider> col_ref) {
     auto col = col_ref.get();
-    ivec2 imin = col->bounds.min / cell_size;
-    ivec2 imax = col->bounds.max / cell_size;
+    ivec2 imin = get_cell(col->bounds.min);
+    ivec2 imax = get_cell(col->bounds.max);
     for (int x = imin.x; x <= imax.x; x++) {
         for (int y = imin.y; y <= imax.y; y++) {
             auto it = spatial_hash.find(ivec2(x, y));
@@ -211,30 +904,18 @@ void CollisionManager::remove_collider(Ref<Collider> col_ref) {
 
 void CollisionManager::update_collider(Ref<Collider> col_ref) {
     auto col = col_ref.get();
-    AABB new_bounds;
-    auto t = col->get_global_trans();
-    auto center = t.get_origin();
-    switch (col->type) {
-        case ColliderType::AABB: {
-            new_bounds.min = center - col->aabb.extents;
-            new_bounds.max = center + col->aabb.extents;
-        } break;
-        case ColliderType::OBB: {
-            auto u = t.basis_xform(vec2(col->obb.extents.x, 0));
-            auto v = t.basis_xform(vec2(0, col->obb.extents.y));
-            vec2 max_extents = glm::max(u, v);
-            new_bounds.min = center - max_extents;
-            new_bounds.max = center + max_extents;
-        } break;
-        case ColliderType::Circle: {
-            new_bounds.min = center - col->circle.radius;
-            new_bounds.max = center + col->circle.radius;
-        } break;
+    assert(!col->is_static);
+    AABB new_bounds = compute_bounds(col);
+    if (use_dense_grid) {
+        col->bounds = new_bounds;
+        mark_grid_stale(col_ref, col);
+        return;
     }
-    ivec2 imin = col->bounds.min / cell_size;
-    ivec2 imax = col->bounds.max / cell_size;
-    ivec2 new_imin = new_bounds.min / cell_size;
-    ivec2 new_imax = new_bounds.max / cell_size;
+    ivec2 imin = get_cell(col->bounds.min);
+    ivec2 imax = get_cell(col->bounds.max);
+    ivec2 new_imin = get_cell(new_bounds.min);
+    ivec2 new_imax = get_cell(new_bounds.max);
+    grow_occupied_cells(new_imin, new_imax);
 
     // Remove old entries
     for (int x = imin.x; x <= imax.x; x++) {
@@ -268,11 +949,332 @@ void CollisionManager::update_collider(Ref<Collider> col_ref) {
     col->bounds = new_bounds;
 }
 
+void CollisionManager::mark_grid_stale(Ref<Collider> col_ref, Collider* col) {
+    if (col->_grid_stale) return;
+    col->_grid_stale = true;
+    grid_stale_colliders.push_back(col_ref);
+}
+
+bool CollisionManager::sweep(const std::vector<Ref<Collider>>& colliders, vec2 dx, SweepHit& out_hit) {
+    ZoneScoped
+
+    if (static_index_dirty) {
+        rebuild_static_index();
+    }
+
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+    bool found = false;
+    for (auto col_ref : colliders) {
+        // Static colliders only live in the static index (and shouldn't move anyway)
+        if (col_ref.get()->is_static) continue;
+        update_collider(col_ref);
+    }
+    for (auto col_ref : colliders) {
+        auto col = col_ref.get();
+        AABB swept_bounds;
+        swept_bounds.min = glm::min(col->bounds.min, col->bounds.min + dx);
+        swept_bounds.max = glm::max(col->bounds.max, col->bounds.max + dx);
+
+        ivec2 imin = get_cell(swept_bounds.min);
+        ivec2 imax = get_cell(swept_bounds.max);
+        for (int x = imin.x; x <= imax.x; x++) {
+            for (int y = imin.y; y <= imax.y; y++) {
+                foreach_in_cell(ivec2(x, y), [&](Ref<Collider> col2_ref) {
+                    if (std::find(colliders.begin(), colliders.end(), col2_ref) != colliders.end()) return;
+
+                    auto col2 = pool.try_get(col2_ref);
+                    if (!col2) return;
+                    if (!layers_interact(col->layer, col->mask, col2->layer, col2->mask)) return;
+                    if (!swept_bounds.collides_with(col2->bounds)) return;
+
+                    float toi;
+                    vec2 normal;
+                    if (sweep_aabb(col->bounds, dx, col2->bounds, toi, normal) && (!found || toi < out_hit.toi)) {
+                        found = true;
+                        out_hit.col = col2_ref;
+                        out_hit.self_col = col_ref;
+                        out_hit.toi = toi;
+                        out_hit.normal = normal;
+                    }
+                });
+            }
+        }
+    }
+    return found;
+}
+
+bool CollisionManager::raycast(vec2 origin, vec2 dir, float max_dist, RaycastHit& out_hit) {
+    ZoneScoped
+
+    float dir_len = glm::length(dir);
+    if (dir_len <= 0 || max_dist < 0) return false;
+    dir /= dir_len;
+
+    if (static_index_dirty) {
+        rebuild_static_index();
+    }
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+
+    bool found = false;
+    out_hit.distance = max_dist;
+    auto test_collider = [&](Ref<Collider> col_ref) {
+        auto col = pool.try_get(col_ref);
+        if (!col) return;
+        float t;
+        vec2 normal;
+        if (raycast_collider(origin, dir, col, t, normal) && t <= out_hit.distance && (!found || t < out_hit.distance)) {
+            found = true;
+            out_hit.col = col_ref;
+            out_hit.distance = t;
+            out_hit.normal = normal;
+        }
+    };
+
+    ivec2 cell_min, cell_max;
+    get_occupied_cells(cell_min, cell_max);
+    if (cell_min.x > cell_max.x || cell_min.y > cell_max.y) return false;
+    // Squares covered by those cells (get_cell() truncates towards zero, so cell 0 covers squares -1 and 0)
+    ivec2 square_min, square_max;
+    for (int i = 0; i < 2; i++) {
+        square_min[i] = cell_min[i] > 0 ? cell_min[i] : cell_min[i] - 1;
+        square_max[i] = cell_max[i] >= 0 ? cell_max[i] : cell_max[i] - 1;
+    }
+
+    // Clip the ray to the occupied squares, there's nothing to hit outside of them.
+    // The dense grid can't be clipped, since colliders outside of it live in its border cells.
+    float t_start = 0;
+    float t_end = max_dist;
+    if (!use_dense_grid) {
+        for (int i = 0; i < 2; i++) {
+            float lo = square_min[i] * cell_size;
+            float hi = (square_max[i] + 1) * cell_size;
+            if (dir[i] == 0) {
+                if (origin[i] < lo || origin[i] > hi) return false;
+                continue;
+            }
+            float t0 = (lo - origin[i]) / dir[i];
+            float t1 = (hi - origin[i]) / dir[i];
+            t_start = glm::max(t_start, glm::min(t0, t1));
+            t_end = glm::min(t_end, glm::max(t0, t1));
+        }
+        if (t_start > t_end) return false;
+    }
+
+    // DDA over cell_size squares. Cells from get_cell() can be merged or clamped versions of these
+    // (around the origin and on the dense grid border), so neighboring squares can map to the same cell.
+    ivec2 square = glm::floor((origin + t_start * dir) / cell_size);
+    if (!use_dense_grid) {
+        square = glm::clamp(square, square_min, square_max);
+    }
+    ivec2 step;
+    vec2 t_max, t_delta;
+    for (int i = 0; i < 2; i++) {
+        if (dir[i] > 0) {
+            step[i] = 1;
+            t_max[i] = ((square[i] + 1) * cell_size - origin[i]) / dir[i];
+            t_delta[i] = cell_size / dir[i];
+        }
+        else if (dir[i] < 0) {
+            step[i] = -1;
+            t_max[i] = (square[i] * cell_size - origin[i]) / dir[i];
+            t_delta[i] = -cell_size / dir[i];
+        }
+        else {
+            step[i] = 0;
+            t_max[i] = FLT_MAX;
+            t_delta[i] = FLT_MAX;
+        }
+    }
+
+    ivec2 last_cell;
+    bool first = true;
+    while (true) {
+        ivec2 ipos = get_cell((vec2(square) + 0.5f) * cell_size);
+        if (first || ipos != last_cell) {
+            foreach_in_cell(ipos, test_collider);
+            last_cell = ipos;
+            first = false;
+        }
+        // Any hit closer than the exit of this square was found in a cell visited so far
+        float t_exit = glm::min(t_max.x, t_max.y);
+        if ((found && out_hit.distance <= t_exit) || t_exit > t_end) break;
+        if (use_dense_grid) {
+            // Once the ray is past the grid on every axis it moves along, all squares map to this same border cell
+            bool past_grid = true;
+            for (int i = 0; i < 2; i++) {
+                if ((step[i] > 0 && square[i] <= square_max[i]) || (step[i] < 0 && square[i] >= square_min[i])) {
+                    past_grid = false;
+                }
+            }
+            if (past_grid) break;
+        }
+
+        int axis = t_max.x < t_max.y ? 0 : 1;
+        square[axis] += step[axis];
+        t_max[axis] += t_delta[axis];
+    }
+
+    if (found) {
+        out_hit.point = origin + out_hit.distance * dir;
+    }
+    return found;
+}
+
+void CollisionManager::overlap_aabb(const AABB& bounds, std::vector<Ref<Collider>>& out_colliders) {
+    ZoneScoped
+
+    out_colliders.clear();
+    if (static_index_dirty) {
+        rebuild_static_index();
+    }
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+
+    BoxShape box;
+    box.center = bounds.center();
+    box.axes[0] = vec2(0.5f * bounds.size().x, 0);
+    box.axes[1] = vec2(0, 0.5f * bounds.size().y);
+
+    ivec2 imin = get_cell(bounds.min);
+    ivec2 imax = get_cell(bounds.max);
+    for (int x = imin.x; x <= imax.x; x++) {
+        for (int y = imin.y; y <= imax.y; y++) {
+            ivec2 ipos = ivec2(x, y);
+            foreach_in_cell(ipos, [&](Ref<Collider> col_ref) {
+                auto col = pool.try_get(col_ref);
+                if (!col || !bounds.collides_with(col->bounds)) return;
+                if (get_owner_cell(bounds, col->bounds) != ipos) return;
+
+                ContactEvent ev;
+                bool overlaps = false;
+                switch (col->type) {
+                    case ColliderType::AABB:
+                        overlaps = true;
+                        break;
+                    case ColliderType::OBB:
+                        overlaps = box_box_collision(box, get_box_shape(col), ev);
+                        break;
+                    case ColliderType::Circle:
+                        overlaps = box_circle_collision(box, col->_get_global_trans_raw().get_origin(),
+                                                        col->circle.radius, ev);
+                        break;
+                }
+                if (overlaps) {
+                    out_colliders.push_back(col_ref);
+                }
+            });
+        }
+    }
+}
+
+void CollisionManager::overlap_circle(vec2 center, float radius, std::vector<Ref<Collider>>& out_colliders) {
+    ZoneScoped
+
+    out_colliders.clear();
+    if (static_index_dirty) {
+        rebuild_static_index();
+    }
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+
+    AABB bounds;
+    bounds.min = center - vec2(radius, radius);
+    bounds.max = center + vec2(radius, radius);
+
+    ivec2 imin = get_cell(bounds.min);
+    ivec2 imax = get_cell(bounds.max);
+    for (int x = imin.x; x <= imax.x; x++) {
+        for (int y = imin.y; y <= imax.y; y++) {
+            ivec2 ipos = ivec2(x, y);
+            foreach_in_cell(ipos, [&](Ref<Collider> col_ref) {
+                auto col = pool.try_get(col_ref);
+                if (!col || !bounds.collides_with(col->bounds)) return;
+                if (get_owner_cell(bounds, col->bounds) != ipos) return;
+
+                if (point_distance(center, col) <= radius) {
+                    out_colliders.push_back(col_ref);
+                }
+            });
+        }
+    }
+}
+
+void CollisionManager::query_nearest(vec2 pos, int k, float max_dist, std::vector<Ref<Collider>>& out_colliders) {
+    ZoneScoped
+
+    out_colliders.clear();
+    if (k <= 0 || max_dist < 0) return;
+    if (static_index_dirty) {
+        rebuild_static_index();
+    }
+    auto& pool = Engine::instance().get_resources()->get_pool<Collider>();
+
+    ivec2 cell_min, cell_max;
+    get_occupied_cells(cell_min, cell_max);
+    if (cell_min.x > cell_max.x || cell_min.y > cell_max.y) return;
+
+    // Max-heap of the k closest colliders found so far. A collider spanning several cells is visited once per cell,
+    // but only needs checking against the heap: if it already got evicted, it's farther than anything left in it.
+    auto compare = [](const std::pair<float, Ref<Collider>>& a, const std::pair<float, Ref<Collider>>& b) {
+        return a.first < b.first || (a.first == b.first && a.second.addr < b.second.addr);
+    };
+    query_candidates.clear();
+    auto test_collider = [&](Ref<Collider> col_ref) {
+        auto col = pool.try_get(col_ref);
+        if (!col) return;
+        std::pair<float, Ref<Collider>> candidate = {point_distance(pos, col), col_ref};
+        if (candidate.first > max_dist) return;
+        if ((int)query_candidates.size() == k && !compare(candidate, query_candidates.front())) return;
+        for (auto& [dist, ref] : query_candidates) {
+            if (ref == col_ref) return;
+        }
+        if ((int)query_candidates.size() == k) {
+            std::pop_heap(query_candidates.begin(), query_candidates.end(), compare);
+            query_candidates.pop_back();
+        }
+        query_candidates.push_back(candidate);
+        std::push_heap(query_candidates.begin(), query_candidates.end(), compare);
+    };
+    auto visit = [&](int x, int y) {
+        if (x >= cell_min.x && x <= cell_max.x && y >= cell_min.y && y <= cell_max.y) {
+            foreach_in_cell(ivec2(x, y), test_collider);
+        }
+    };
+
+    // Search rings of cells around pos, starting from the first one that reaches the occupied cells.
+    // Everything outside of ring r is at least r * cell_size away, so we can stop once the k-th closest collider
+    // is closer than that, or once the ring covers all occupied cells.
+    ivec2 center = get_cell(pos);
+    int first_ring = glm::max(glm::max(cell_min.x - center.x, center.x - cell_max.x),
+                              glm::max(cell_min.y - center.y, center.y - cell_max.y));
+    int max_ring = (int)glm::min(glm::ceil(max_dist / cell_size) + 1, 65536.0f);
+    for (int r = glm::max(first_ring, 0); r <= max_ring; r++) {
+        // Only walk the perimeter of the ring, clipped to the occupied cells
+        int x0 = glm::max(center.x - r, cell_min.x), x1 = glm::min(center.x + r, cell_max.x);
+        int y0 = glm::max(center.y - r + 1, cell_min.y), y1 = glm::min(center.y + r - 1, cell_max.y);
+        for (int x = x0; x <= x1; x++) {
+            visit(x, center.y - r);
+            if (r > 0) visit(x, center.y + r);
+        }
+        for (int y = y0; y <= y1; y++) {
+            visit(center.x - r, y);
+            visit(center.x + r, y);
+        }
+
+        if ((int)query_candidates.size() == k && query_candidates.front().first <= r * cell_size) break;
+        if (center.x - r <= cell_min.x && center.y - r <= cell_min.y &&
+            center.x + r >= cell_max.x && center.y + r >= cell_max.y) {
+            break;
+        }
+    }
+
+    std::sort_heap(query_candidates.begin(), query_candidates.end(), compare);
+    for (auto& [dist, col_ref] : query_candidates) {
+        out_colliders.push_back(col_ref);
+    }
+}
+
 void CollisionManager::debug_render() {
     auto res = Engine::instance().get_resources();
-    sgp_set_color(1, 1, 1, 1);
-    for (auto& [ipos, entry] : spatial_hash) {
-        if (entry.colliders.empty()) continue;
+    auto draw_cell = [this](ivec2 ipos) {
         sgp_point p[4];
         p[0] = {(ipos.x + 0)*cell_size, (ipos.y + 0)*cell_size};
         p[1] = {(ipos.x + 0)*cell_size, (ipos.y + 1)*cell_size};
@@ -284,6 +1286,33 @@ void CollisionManager::debug_render() {
         l[2] = {p[2], p[3]};
         l[3] = {p[3], p[0]};
         sgp_draw_lines(l, 4);
+    };
+    if (use_dense_grid) {
+        auto draw_grid = [&](const DenseGrid& grid) {
+            for (int y = 0; y < grid.size.y; y++) {
+                for (int x = 0; x < grid.size.x; x++) {
+                    ivec2 ipos = grid.origin + ivec2(x, y);
+                    if (grid.get_cell(ipos).count > 0) {
+                        draw_cell(ipos);
+                    }
+                }
+            }
+        };
+        sgp_set_color(0.5f, 0.5f, 0.5f, 1);
+        draw_grid(static_grid);
+        sgp_set_color(1, 1, 1, 1);
+        draw_grid(dynamic_grid);
+    }
+    else {
+        sgp_set_color(0.5f, 0.5f, 0.5f, 1);
+        for (auto& [ipos, range] : static_index.cells) {
+            draw_cell(ipos);
+        }
+        sgp_set_color(1, 1, 1, 1);
+        for (auto& [ipos, entry] : spatial_hash) {
+            if (entry.colliders.empty()) continue;
+            draw_cell(ipos);
+        }
     }
     sgp_set_color(0, 1, 0, 1);
     res->foreach<Collider>([](Collider& col) {
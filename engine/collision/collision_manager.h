@@ -7,14 +7,17 @@
 #include <glm/gtx/hash.hpp>
 
 #include "collider.h"
+#include "collider_soa.h"
 
 #include "core/types.h"
 #include "core/rect.h"
 #include "core/reflect.h"
+#include "core/arena_allocator.h"
 #include "render/node.h"
 #include "resource_pool.h"
 
 #include <vector>
+#include <climits>
 
 // A simple spatial hash structure that checks collision between colliders.
 
@@ -22,6 +25,106 @@ struct SpatialHashEntry {
     std::vector<Ref<Collider>> colliders;
 };
 
+// Per-frame narrow phase counters.
+struct CollisionStats {
+    uint32_t pair_tests = 0;        // Pairs that went through the narrow phase
+    uint32_t duplicate_pairs = 0;   // Pairs skipped because another shared cell owns them
+    uint32_t contacts = 0;
+
+    CollisionStats& operator+=(const CollisionStats& other) {
+        pair_tests += other.pair_tests;
+        duplicate_pairs += other.duplicate_pairs;
+        contacts += other.contacts;
+        return *this;
+    }
+};
+
+// First collider hit by a swept query.
+struct SweepHit {
+    Ref<Collider> col;          // The collider that got hit
+    Ref<Collider> self_col;     // The swept collider that hit it
+    float toi = 1.0f;           // Fraction of the motion travelled before the hit, in [0, 1]
+    vec2 normal = {0, 0};       // Normal of the hit surface, pointing towards the swept collider
+};
+
+// First collider hit by a raycast.
+struct RaycastHit {
+    Ref<Collider> col;
+    vec2 point = {0, 0};
+    vec2 normal = {0, 0};
+    float distance = 0;
+};
+
+// Colliders overlapping one cell, as a range of a packed collider array.
+struct CellSpan {
+    const ColliderSoA* cols = nullptr;
+    uint32_t begin = 0, count = 0;
+};
+
+// Occupied cell that goes through the narrow phase.
+struct ActiveCell {
+    ivec2 ipos;
+    CellSpan span;
+};
+
+// Bounded grid whose cell contents are offsets into one contiguous array.
+// It's rebuilt from scratch with a counting sort, so there's no hashing or per-cell allocation.
+struct DenseGrid {
+    ivec2 origin = {0, 0};  // Index of the first cell
+    ivec2 size = {0, 0};    // Number of cells in each axis
+    std::vector<uint32_t> offsets;
+    ColliderSoA cols;
+
+    inline int cell_index(ivec2 ipos) const {
+        return (ipos.y - origin.y) * size.x + (ipos.x - origin.x);
+    }
+
+    inline CellSpan get_cell(ivec2 ipos) const {
+        int i = cell_index(ipos);
+        return {&cols, offsets[i], offsets[i + 1] - offsets[i]};
+    }
+};
+
+// Range of colliders in StaticIndex::cols that overlap one cell.
+struct StaticCellRange {
+    uint32_t begin, count;
+};
+
+// Flattened grid of static colliders: each cell maps to a contiguous range of items.
+// Built once, and only rebuilt when static colliders are added or removed.
+struct StaticIndex {
+    phmap::flat_hash_map<ivec2, StaticCellRange> cells;
+    ColliderSoA cols;
+
+    void clear() {
+        cells.clear();
+        cols.clear();
+    }
+};
+
+// Pair that passed the broadphase, with col1 having the lower shape type.
+struct ContactCandidate {
+    Ref<Collider> col1_ref, col2_ref;
+    Collider* col1;
+    Collider* col2;
+};
+
+// Number of distinct (type, type) pairs between collider shapes
+constexpr int num_shape_pairs = 6;
+
+// Per-thread scratch buffers for the narrow phase.
+struct NarrowPhaseScratch {
+    std::vector<uint32_t> candidates;
+    // Candidate pairs bucketed by shape pair, so each bucket runs through one narrow phase function
+    std::vector<ContactCandidate> buckets[num_shape_pairs];
+};
+
+// Range of contacts a narrow phase chunk wrote into one of the per-thread buffers.
+struct ContactChunk {
+    int thread;
+    uint32_t begin, end;
+};
+
 CLASS() CollisionManager {
 public:
     friend class Collider;
@@ -33,17 +136,132 @@ public:
     void update();
 
     void update_partial(const std::vector<Ref<Collider>>& colliders,
-                        std::vector<ContactEvent>& out_contact_events);
+                        arena_vector<ContactEvent>& out_contact_events);
+
+    // Sweeps the bounds of the given colliders along dx and finds the earliest hit (time of impact).
+    // Uses the AABB bounds of both sides, so rotated boxes and circles are treated conservatively.
+    // The swept colliders never hit each other, and colliders that already overlap at the start are ignored.
+    bool sweep(const std::vector<Ref<Collider>>& colliders, vec2 dx, SweepHit& out_hit);
+
+    // Spatial queries against the broadphase (dynamic colliders are found at their bounds from the last update()).
+    // The overlap queries clear out_colliders and write the results into it,
+    // so callers can keep the vector around and avoid allocating per query.
+
+    // Walks the cells along the ray and finds the closest collider hit within max_dist.
+    // Colliders containing the ray origin are ignored.
+    bool raycast(vec2 origin, vec2 dir, float max_dist, RaycastHit& out_hit);
+    // Colliders whose shape overlaps the given box.
+    void overlap_aabb(const AABB& bounds, std::vector<Ref<Collider>>& out_colliders);
+    // Colliders whose shape overlaps the given circle.
+    void overlap_circle(vec2 center, float radius, std::vector<Ref<Collider>>& out_colliders);
+    // Up to k colliders closest to pos (within max_dist), sorted by distance.
+    void query_nearest(vec2 pos, int k, float max_dist, std::vector<Ref<Collider>>& out_colliders);
 
     void debug_render();
 
+    const CollisionStats& get_stats() const { return stats; }
+
+    // Called by Node when the global transform of a collider gets invalidated.
+    void notify_transform(Ref<Collider> col_ref);
+
+    // Switch the broadphase to dense grids covering the given world bounds (ex. a finite tilemap).
+    // Colliders outside of the bounds are put into the border cells. Calling it again extends the grids
+    // to cover both bounds (ex. a second finite map).
+    void set_bounds(const AABB& world_bounds);
+    // Switch back to the spatial hash (ex. when the scene with the map unloads).
+    void clear_bounds();
+
 private:
     void add_collider(Ref<Collider> col_ref);
     void remove_collider(Ref<Collider> col_ref);
     void update_collider(Ref<Collider> col_ref);
+    void mark_grid_stale(Ref<Collider> col_ref, Collider* col);
+
+    void rebuild_static_index();
+    void build_dense_grid(DenseGrid& grid, const std::vector<Ref<Collider>>& colliders);
+
+    CellSpan get_static_cell(ivec2 ipos) const;
+
+    // Calls fun(col_ref) for every collider (dynamic and static) in the cell.
+    template <class Fun>
+    void foreach_in_cell(ivec2 ipos, Fun&& fun);
+
+    // Cells outside of [imin, imax] have no colliders in them. With the dense grid this is the whole grid,
+    // since positions outside of it map to the border cells. Empty if imin > imax.
+    inline void get_occupied_cells(ivec2& imin, ivec2& imax) const {
+        if (use_dense_grid) {
+            imin = dynamic_grid.origin;
+            imax = dynamic_grid.origin + dynamic_grid.size - 1;
+        }
+        else {
+            imin = occupied_min;
+            imax = occupied_max;
+        }
+    }
+
+    inline void grow_occupied_cells(ivec2 imin, ivec2 imax) {
+        occupied_min = glm::min(occupied_min, imin);
+        occupied_max = glm::max(occupied_max, imax);
+    }
+
+    inline ivec2 get_cell(vec2 pos) const {
+        ivec2 ipos = pos / cell_size;
+        if (use_dense_grid) {
+            ipos = glm::clamp(ipos, dynamic_grid.origin, dynamic_grid.origin + dynamic_grid.size - 1);
+        }
+        return ipos;
+    }
+
+    // Work items [0, active_cells.size()) are dynamic-dynamic tests inside one cell,
+    // the rest are dynamic-static tests for one dynamic collider.
+    void find_contacts(int item_begin, int item_end, NarrowPhaseScratch& scratch,
+                       std::vector<ContactEvent>& out_contact_events, CollisionStats& out_stats);
+
+    // A pair of colliders sharing multiple cells is only tested in the cell containing
+    // the min corner of their bounds intersection.
+    inline ivec2 get_owner_cell(const AABB& b1, const AABB& b2) const {
+        return get_cell(glm::max(b1.min, b2.min));
+    }
+
+    // Work is split into fixed-size chunks, so the merge order doesn't depend on the thread count.
+    static constexpr int items_per_chunk = 64;
+    // Below this many work items the narrow phase just runs on the main thread.
+    static constexpr int min_items_for_parallel = 4 * items_per_chunk;
 
     float cell_size;
+    // Only holds dynamic colliders, static ones live in static_index.
     phmap::flat_hash_map<ivec2, SpatialHashEntry> spatial_hash;
+    // Range covering the occupied cells of spatial_hash and static_index. It only grows between updates,
+    // so it can be larger than needed, and update() shrinks it back.
+    ivec2 occupied_min = ivec2(INT_MAX), occupied_max = ivec2(INT_MIN);
+    ivec2 static_occupied_min = ivec2(INT_MAX), static_occupied_max = ivec2(INT_MIN);
+
+    // Used instead of spatial_hash and static_index when the world bounds are known
+    bool use_dense_grid = false;
+    AABB grid_bounds;
+    DenseGrid dynamic_grid;
+    DenseGrid static_grid;
+    std::vector<uint32_t> grid_cursors;
+    // Dynamic colliders created or moved since dynamic_grid got built (it's only rebuilt in update()),
+    // queries test these at their current bounds instead of at their grid cells
+    std::vector<Ref<Collider>> grid_stale_colliders;
+
+    std::vector<Ref<Collider>> dynamic_colliders;
+    std::vector<Ref<Collider>> static_colliders;
+    // Colliders that moved since the last update
+    std::vector<Ref<Collider>> dirty_colliders;
+    StaticIndex static_index;
+    bool static_index_dirty = false;
 
     std::vector<ContactEvent> contact_events;
+    CollisionStats stats;
+
+    // Scratch buffers for the narrow phase (kept around to avoid reallocating every frame)
+    std::vector<ActiveCell> active_cells;
+    ColliderSoA active_cols; // Packed contents of active cells when using the spatial hash
+    std::vector<NarrowPhaseScratch> thread_scratch;
+    std::vector<std::vector<ContactEvent>> thread_contact_events;
+    std::vector<CollisionStats> thread_stats;
+    std::vector<ContactChunk> contact_chunks;
+    std::vector<std::pair<float, Ref<Collider>>> query_candidates;
 };
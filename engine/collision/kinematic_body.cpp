@@ -3,51 +3,80 @@
 #include "collision/collision_manager.h"
 #include "squirrel/vm.h"
 
+#include <glm/gtx/norm.hpp>
+#include <Tracy.hpp>
+
 KinematicBody::Options::Options(sq::Table table) {
     auto vm = Engine::instance().get_vm();
     margin = vm->get_or_default<float>(table, "margin", margin);
+    max_slide_steps = vm->get_or_default<int>(table, "max_slide_steps", max_slide_steps);
 }
 
-void KinematicBody::move_and_collide(vec2 dx) {
-    log_error("KinematicBody::move_and_collide() is unimplemented!");
+bool KinematicBody::move_and_collide(vec2 dx) {
+    ZoneScoped
+
+    auto col_mgr = Engine::instance().get_collision_manager();
+    SweepHit hit;
+    if (!col_mgr->sweep(colliders, dx, hit)) {
+        translate(dx);
+        return false;
+    }
+
+    // Stop a bit before the time of impact, so we don't start the next move touching the surface
+    float len = glm::length(dx);
+    float t = len > 0 ? glm::max(0.0f, hit.toi - margin / len) : 0.0f;
+    translate(t * dx);
+    return true;
+}
 
-    auto old_pos = get_pos();
-    translate(dx);
+void KinematicBody::move_and_slide(vec2 dx) {
+    ZoneScoped
 
     auto col_mgr = Engine::instance().get_collision_manager();
-    std::vector<ContactEvent> contact_events;
-    col_mgr->update_partial(colliders, contact_events);
 
-    if (!contact_events.empty()) {
-        set_pos(old_pos);
-        // TODO: Need to do CCD?
+    int steps = 0;
+    while (steps < max_slide_steps && glm::length2(dx) > 0) {
+        ZoneScopedN("KinematicBody Slide Step")
+        steps++;
+
+        SweepHit hit;
+        if (!col_mgr->sweep(colliders, dx, hit)) {
+            translate(dx);
+            break;
+        }
+
+        float len = glm::length(dx);
+        float t = glm::max(0.0f, hit.toi - margin / len);
+        translate(t * dx);
+
+        // Slide the remaining motion along the hit surface
+        vec2 rest = (1.0f - t) * dx;
+        dx = rest - glm::dot(rest, hit.normal) * hit.normal;
     }
+    TracyPlot("KinematicBody Slide Steps", (int64_t)steps);
+
+    depenetrate();
 }
 
-void KinematicBody::move_and_slide(vec2 dx) {
-    auto old_pos = get_pos();
-    translate(dx);
+void KinematicBody::depenetrate() {
+    ZoneScoped
 
     auto col_mgr = Engine::instance().get_collision_manager();
-    std::vector<ContactEvent> contact_events;
+    arena_vector<ContactEvent> contact_events(&Engine::instance().get_frame_allocator());
 
-    while (true) {
+    for (int i = 0; i < max_slide_steps; i++) {
         contact_events.clear();
         col_mgr->update_partial(colliders, contact_events);
         if (contact_events.empty()) break;
 
-        set_pos(old_pos);
-        int max_depth = INT32_MIN;
-        int max_depth_contact_idx = -1;
-        for (int i = 0; i < contact_events.size(); i++) {
-            if (contact_events[i].depth > max_depth) {
-                max_depth = contact_events[i].depth;
-                max_depth_contact_idx = i;
+        int max_depth_contact_idx = 0;
+        for (int j = 1; j < contact_events.size(); j++) {
+            if (contact_events[j].depth > contact_events[max_depth_contact_idx].depth) {
+                max_depth_contact_idx = j;
             }
         }
         auto& ev = contact_events[max_depth_contact_idx];
-        dx -= ev.depth * ev.normal;
-        translate(dx);
+        translate(-ev.depth * ev.normal);
     }
 }
 
@@ -7,19 +7,27 @@
 CLASS(Resource, Node) KinematicBody : public Node {
 private:
     float margin = 0.1;
+    int max_slide_steps = 4;
     std::vector<Ref<Collider>> colliders;
 
+    // Pushes the body out of colliders it still overlaps (at most max_slide_steps times).
+    void depenetrate();
+
 public:
     struct Options {
         float margin = 0.1;
+        int max_slide_steps = 4;
         Options() = default;
         Options(sq::Table table);
     };
 
     KinematicBody() = default;
-    KinematicBody(const Options& opt) : margin(opt.margin) {}
+    KinematicBody(const Options& opt) : margin(opt.margin), max_slide_steps(opt.max_slide_steps) {}
 
-    void move_and_collide(vec2 dx);
+    // Moves until the first collider in the way (stopping margin units before it).
+    // Returns true if something was hit.
+    bool move_and_collide(vec2 dx);
+    // Moves and slides along the hit surfaces, using at most max_slide_steps time of impact steps.
     void move_and_slide(vec2 dx);
 
     void add_collider(Ref<Collider> col_ref);
@@ -0,0 +1,168 @@
+//
+// Created by lasagnaphil on 10/17/2026.
+//
+
+#include "alloc_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <Tracy.hpp>
+
+namespace {
+
+struct AllocCounters {
+    std::atomic<int64_t> live_bytes = 0;
+    std::atomic<uint64_t> total_allocs = 0;
+    std::atomic<uint64_t> frame_allocs = 0;
+    std::atomic<uint64_t> frame_bytes = 0;
+    // Snapshot of the last finished frame
+    std::atomic<uint64_t> last_frame_allocs = 0;
+    std::atomic<uint64_t> last_frame_bytes = 0;
+};
+
+AllocCounters counters[(int)AllocTag::Count];
+std::atomic<int64_t> committed_bytes = 0;
+
+thread_local AllocTag cur_tag = AllocTag::Other;
+
+// Tracy memory pool names (Tracy compares them by pointer, so they have to stay the same)
+const char* tag_names[(int)AllocTag::Count] = {
+    "Other", "Render", "Collision", "Script", "Text", "Tilemap"
+};
+const char* committed_pool_name = "Committed";
+
+}
+
+const char* alloc_tag_name(AllocTag tag) {
+    return tag_names[(int)tag];
+}
+
+AllocScope::AllocScope(AllocTag tag) : prev_tag(cur_tag) {
+    cur_tag = tag;
+}
+
+AllocScope::~AllocScope() {
+    cur_tag = prev_tag;
+}
+
+AllocTag alloc_current_tag() {
+    return cur_tag;
+}
+
+void alloc_track(void* ptr, size_t size, AllocTag tag) {
+    auto& c = counters[(int)tag];
+    c.live_bytes.fetch_add((int64_t)size, std::memory_order_relaxed);
+    c.total_allocs.fetch_add(1, std::memory_order_relaxed);
+    c.frame_allocs.fetch_add(1, std::memory_order_relaxed);
+    c.frame_bytes.fetch_add(size, std::memory_order_relaxed);
+    TracyAllocN(ptr, size, tag_names[(int)tag]);
+}
+
+void alloc_track_free(void* ptr, size_t size, AllocTag tag) {
+    counters[(int)tag].live_bytes.fetch_sub((int64_t)size, std::memory_order_relaxed);
+    TracyFreeN(ptr, tag_names[(int)tag]);
+}
+
+void alloc_track_commit(size_t bytes) {
+    committed_bytes.fetch_add((int64_t)bytes, std::memory_order_relaxed);
+}
+
+void alloc_track_decommit(size_t bytes) {
+    committed_bytes.fetch_sub((int64_t)bytes, std::memory_order_relaxed);
+}
+
+void alloc_track_committed_range(void* base, size_t old_bytes, size_t new_bytes) {
+    if (old_bytes > 0) {
+        TracyFreeN(base, committed_pool_name);
+    }
+    if (new_bytes > 0) {
+        TracyAllocN(base, new_bytes, committed_pool_name);
+    }
+}
+
+void alloc_next_frame() {
+    for (auto& c : counters) {
+        c.last_frame_allocs.store(c.frame_allocs.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        c.last_frame_bytes.store(c.frame_bytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+AllocStats alloc_get_stats(AllocTag tag) {
+    auto& c = counters[(int)tag];
+    AllocStats stats;
+    stats.live_bytes = c.live_bytes.load(std::memory_order_relaxed);
+    stats.total_allocs = c.total_allocs.load(std::memory_order_relaxed);
+    stats.frame_allocs = c.last_frame_allocs.load(std::memory_order_relaxed);
+    stats.frame_bytes = c.last_frame_bytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t alloc_get_frame_allocs() {
+    uint64_t allocs = 0;
+    for (auto& c : counters) {
+        allocs += c.last_frame_allocs.load(std::memory_order_relaxed);
+    }
+    return allocs;
+}
+
+int64_t alloc_get_committed_bytes() {
+    return committed_bytes.load(std::memory_order_relaxed);
+}
+
+#ifdef THESYSTEM_TRACK_ALLOCATIONS
+
+// Every allocation gets a header with its size and tag, so frees are counted against the right subsystem
+// even without sized delete. 16 bytes keeps the default new alignment.
+namespace {
+
+struct alignas(16) AllocHeader {
+    size_t size;
+    AllocTag tag;
+};
+static_assert(sizeof(AllocHeader) == 16);
+
+void* tracked_alloc(size_t size) {
+    auto header = static_cast<AllocHeader*>(std::malloc(sizeof(AllocHeader) + size));
+    if (!header) return nullptr;
+    header->size = size;
+    header->tag = cur_tag;
+    void* ptr = header + 1;
+    alloc_track(ptr, size, header->tag);
+    return ptr;
+}
+
+void tracked_free(void* ptr) {
+    if (!ptr) return;
+    auto header = static_cast<AllocHeader*>(ptr) - 1;
+    alloc_track_free(ptr, header->size, header->tag);
+    std::free(header);
+}
+
+}
+
+// The engine builds without exceptions, so running out of memory aborts instead of throwing std::bad_alloc
+void* operator new(size_t size) {
+    void* ptr = tracked_alloc(size);
+    if (!ptr) std::abort();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    void* ptr = tracked_alloc(size);
+    if (!ptr) std::abort();
+    return ptr;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size); }
+
+void operator delete(void* ptr) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr) noexcept { tracked_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { tracked_free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { tracked_free(ptr); }
+
+#endif
@@ -0,0 +1,71 @@
+//
+// Created by lasagnaphil on 10/17/2026.
+//
+
+#ifndef THESYSTEM_ALLOC_TRACKER_H
+#define THESYSTEM_ALLOC_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocation counters per subsystem. Build with THESYSTEM_TRACK_ALLOCATIONS to replace the global
+// operator new/delete with counting (and Tracy memory profiling) versions, otherwise all counters stay at zero.
+// virtual_commit/virtual_decommit are always counted.
+
+#ifdef THESYSTEM_TRACK_ALLOCATIONS
+constexpr bool alloc_tracking_enabled = true;
+#else
+constexpr bool alloc_tracking_enabled = false;
+#endif
+
+enum class AllocTag : uint8_t {
+    Other,
+    Render,
+    Collision,
+    Script,
+    Text,
+    Tilemap,
+    Count
+};
+
+const char* alloc_tag_name(AllocTag tag);
+
+struct AllocStats {
+    int64_t live_bytes = 0;
+    uint64_t total_allocs = 0;
+    uint64_t frame_allocs = 0;  // During the last finished frame
+    uint64_t frame_bytes = 0;
+};
+
+// Attributes the heap allocations of this thread to a subsystem until the scope ends.
+class AllocScope {
+    AllocTag prev_tag;
+public:
+    explicit AllocScope(AllocTag tag);
+    ~AllocScope();
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+};
+
+AllocTag alloc_current_tag();
+
+// Called by the operator new/delete replacements
+void alloc_track(void* ptr, size_t size, AllocTag tag);
+void alloc_track_free(void* ptr, size_t size, AllocTag tag);
+
+// Called by virtual_commit/virtual_decommit
+void alloc_track_commit(size_t bytes);
+void alloc_track_decommit(size_t bytes);
+// Reports the committed part of a reservation to Tracy's memory profiler after it went from old_bytes to new_bytes.
+// Tracy matches frees by address, so it shows up as one allocation at the start of the reservation.
+void alloc_track_committed_range(void* base, size_t old_bytes, size_t new_bytes);
+
+// Closes the current frame, so the frame counters of alloc_get_stats() report it.
+void alloc_next_frame();
+
+AllocStats alloc_get_stats(AllocTag tag);
+uint64_t alloc_get_frame_allocs(); // All tags, during the last finished frame
+int64_t alloc_get_committed_bytes();
+
+#endif //THESYSTEM_ALLOC_TRACKER_H
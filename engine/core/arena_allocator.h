@@ -5,11 +5,16 @@
 #ifndef THESYSTEM_ARENA_ALLOCATOR_H
 #define THESYSTEM_ARENA_ALLOCATOR_H
 
-#include <string>
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <memory>
+#include <vector>
+#include <utility>
 
-inline void* aligned_alloc(std::size_t size, std::size_t alignment){
+// (Named so it doesn't clash with C11's ::aligned_alloc, which takes its arguments the other way around)
+inline void* arena_aligned_alloc(std::size_t size, std::size_t alignment){
     if(alignment < alignof(void*)) {
         alignment = alignof(void*);
     }
@@ -21,71 +26,166 @@ inline void* aligned_alloc(std::size_t size, std::size_t alignment){
     return aligned_mem;
 }
 
-inline void aligned_free(void* p) noexcept {
+inline void arena_aligned_free(void* p) noexcept {
     ::operator delete(*(static_cast<void**>(p) - 1));
 }
 
+// Bump allocator. When the current block runs out, a new block gets chained instead of failing,
+// and reset() merges the chain into one big block, so after a few frames it stops touching the heap.
 class arena_allocator
 {
-    uint8_t* data;
-    size_t capacity;
-    size_t size;
+    struct Block {
+        uint8_t* data;
+        size_t capacity;
+    };
+
+    static constexpr size_t block_alignment = alignof(std::max_align_t);
+
+    std::vector<Block> blocks;
+    size_t cur_block = 0;
+    size_t size = 0;        // Used bytes in the current block
+    size_t used_before = 0; // Used bytes in the blocks before the current one
     const char* name;
 
+    Block& chain_block(size_t min_capacity) {
+        size_t capacity = std::max(blocks.back().capacity * 2, min_capacity);
+        blocks.push_back({(uint8_t*)arena_aligned_alloc(capacity, block_alignment), capacity});
+        used_before += size;
+        size = 0;
+        cur_block = blocks.size() - 1;
+        return blocks.back();
+    }
+
 public:
-    explicit arena_allocator(size_t capacity, const char* name = NULL) : capacity(capacity), name(name) {
-        data = (uint8_t*)aligned_alloc(capacity, alignof(void*));
+    explicit arena_allocator(size_t capacity = 64 * 1024, const char* name = NULL) : name(name) {
+        blocks.push_back({(uint8_t*)arena_aligned_alloc(capacity, block_alignment), capacity});
     }
     ~arena_allocator() {
-        aligned_free(data);
+        for (auto& block : blocks) {
+            arena_aligned_free(block.data);
+        }
     }
-    arena_allocator(const arena_allocator& other, const char* name = NULL) :
-        data((uint8_t*)aligned_alloc(other.capacity, alignof(void*))),
-        capacity(other.capacity), size(other.size), name(name) {
 
-        std::memcpy(data, other.data, other.capacity);
-    }
+    // Memory handed out by the arena can't be copied along with it
+    arena_allocator(const arena_allocator& other) = delete;
+    arena_allocator& operator=(const arena_allocator& other) = delete;
 
-    arena_allocator& operator=(const arena_allocator& other) {
-        using std::swap;
-        arena_allocator copy(other);
-        swap(*this, copy);
-        return *this;
+    arena_allocator(arena_allocator&& other) noexcept : name(NULL) {
+        swap(*this, other);
     }
 
-    arena_allocator(arena_allocator&& other) noexcept {
+    arena_allocator& operator=(arena_allocator&& other) noexcept {
         swap(*this, other);
+        return *this;
     }
 
     friend void swap(arena_allocator& lhs, arena_allocator& rhs) noexcept {
-        std::swap(lhs.data, rhs.data);
+        std::swap(lhs.blocks, rhs.blocks);
+        std::swap(lhs.cur_block, rhs.cur_block);
         std::swap(lhs.size, rhs.size);
-        std::swap(lhs.capacity, rhs.capacity);
+        std::swap(lhs.used_before, rhs.used_before);
         std::swap(lhs.name, rhs.name);
     }
 
     void* allocate(size_t n, int flags = 0) {
-        void* ptr = data + size;
-        size += n;
-        return ptr;
+        return allocate(n, alignof(std::max_align_t), 0, flags);
     }
 
+    // Returns memory where (ptr + offset) is aligned to alignment (a power of two).
     void* allocate(size_t n, size_t alignment, size_t offset, int flags = 0) {
-        size = ((size - 1 - offset) / alignment + 1) * alignment + offset;
-        void* ptr = data + size;
-        size += n;
-        return ptr;
+        Block* block = &blocks[cur_block];
+        auto align = [&](Block* b) {
+            uintptr_t base = reinterpret_cast<uintptr_t>(b->data);
+            uintptr_t aligned = ((base + size + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - offset;
+            return (size_t)(aligned - base);
+        };
+        size_t pos = align(block);
+        if (pos + n > block->capacity) {
+            block = &chain_block(n + offset + alignment);
+            pos = align(block);
+        }
+        size = pos + n;
+        return block->data + pos;
     }
 
     void deallocate(void* p, size_t n) {
         // Do nothing
     }
 
+    // Frees everything allocated so far. Chained blocks get merged into one that fits all of them.
+    void reset() {
+        if (blocks.size() > 1) {
+            size_t capacity = 0;
+            for (auto& block : blocks) {
+                capacity += block.capacity;
+                arena_aligned_free(block.data);
+            }
+            blocks.clear();
+            blocks.push_back({(uint8_t*)arena_aligned_alloc(capacity, block_alignment), capacity});
+        }
+        cur_block = 0;
+        size = 0;
+        used_before = 0;
+    }
+
+    size_t used_bytes() const { return used_before + size; }
+    size_t capacity() const {
+        size_t capacity = 0;
+        for (auto& block : blocks) capacity += block.capacity;
+        return capacity;
+    }
+    size_t block_count() const { return blocks.size(); }
+
     const char* get_name() const { return name; }
     void        set_name(const char* name) { this->name = name; }
 };
 
-inline bool operator==(const arena_allocator&, const arena_allocator&) { return true;  }
-inline bool operator!=(const arena_allocator&, const arena_allocator&) { return false; }
+// Two arenas used on alternate frames: next_frame() resets the older one, so memory allocated
+// during a frame stays valid until the end of the next one.
+class frame_arena
+{
+    arena_allocator arenas[2];
+    int cur = 0;
+
+public:
+    explicit frame_arena(size_t capacity = 1024 * 1024, const char* name = NULL)
+        : arenas{arena_allocator(capacity, name), arena_allocator(capacity, name)} {}
+
+    void next_frame() {
+        cur = 1 - cur;
+        arenas[cur].reset();
+    }
+
+    arena_allocator& get() { return arenas[cur]; }
+    arena_allocator& get_previous() { return arenas[1 - cur]; }
+};
+
+// Adapter for STL containers (deallocation is a no-op, so growing containers should reserve up front).
+template <class T>
+struct arena_stl_allocator {
+    using value_type = T;
+
+    arena_allocator* arena;
+
+    arena_stl_allocator(arena_allocator* arena) noexcept : arena(arena) {}
+    template <class U>
+    arena_stl_allocator(const arena_stl_allocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T), 0));
+    }
+    void deallocate(T* p, size_t n) noexcept {}
+
+    template <class U>
+    bool operator==(const arena_stl_allocator<U>& other) const { return arena == other.arena; }
+    template <class U>
+    bool operator!=(const arena_stl_allocator<U>& other) const { return arena != other.arena; }
+};
+
+template <class T>
+using arena_vector = std::vector<T, arena_stl_allocator<T>>;
+
+inline bool operator==(const arena_allocator& lhs, const arena_allocator& rhs) { return &lhs == &rhs; }
+inline bool operator!=(const arena_allocator& lhs, const arena_allocator& rhs) { return &lhs != &rhs; }
 
 #endif //THESYSTEM_ARENA_ALLOCATOR_H
@@ -0,0 +1,58 @@
+//
+// Created by lasagnaphil on 10/17/2026.
+//
+
+#ifndef THESYSTEM_RADIX_SORT_H
+#define THESYSTEM_RADIX_SORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+// Stable LSD radix sort of items by a 64-bit key, one byte per pass. All byte histograms are built in a single
+// pass over the keys, and passes where every key has the same byte are skipped, so keys that only use a few
+// bits (like sprite order ids: a handful of layers, z indices and textures) only take a few passes.
+// scratch needs room for n items, the sorted result ends up in items.
+template <class T, class KeyFn>
+void radix_sort(T* items, T* scratch, size_t n, KeyFn&& key_fn) {
+    constexpr int num_passes = sizeof(uint64_t);
+    static_assert(std::is_trivially_copyable_v<T>, "radix_sort moves items with memcpy");
+    if (n <= 1) return;
+
+    uint32_t counts[num_passes][256];
+    std::memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; i++) {
+        uint64_t key = key_fn(items[i]);
+        for (int pass = 0; pass < num_passes; pass++) {
+            counts[pass][(key >> (pass * 8)) & 0xff]++;
+        }
+    }
+
+    T* src = items;
+    T* dst = scratch;
+    for (int pass = 0; pass < num_passes; pass++) {
+        uint32_t* count = counts[pass];
+        int shift = pass * 8;
+        if (count[(key_fn(src[0]) >> shift) & 0xff] == n) continue;
+
+        uint32_t offset = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            uint32_t c = count[digit];
+            count[digit] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint32_t digit = (key_fn(src[i]) >> shift) & 0xff;
+            std::memcpy(&dst[count[digit]++], &src[i], sizeof(T));
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != items) {
+        std::memcpy(items, src, n * sizeof(T));
+    }
+}
+
+#endif //THESYSTEM_RADIX_SORT_H
@@ -0,0 +1,88 @@
+//
+// Created by lasagnaphil on 10/17/2026.
+//
+
+#include "thread_pool.h"
+
+#include <Tracy.hpp>
+
+ThreadPool::ThreadPool(int num_threads) {
+    if (num_threads <= 0) {
+        num_threads = (int)std::thread::hardware_concurrency();
+        if (num_threads <= 0) num_threads = 1;
+    }
+    workers.reserve(num_threads - 1);
+    for (int i = 1; i < num_threads; i++) {
+        workers.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    job_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(int num_chunks, const std::function<void(int, int)>& fun) {
+    if (num_chunks <= 0) return;
+    if (workers.empty() || num_chunks == 1) {
+        for (int i = 0; i < num_chunks; i++) {
+            fun(i, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job_fun = &fun;
+        job_num_chunks = num_chunks;
+        next_chunk.store(0, std::memory_order_relaxed);
+        busy_workers = (int)workers.size();
+        job_generation++;
+    }
+    job_cv.notify_all();
+
+    // The calling thread works on the job too instead of just waiting
+    run_chunks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this]() { return busy_workers == 0; });
+    job_fun = nullptr;
+}
+
+void ThreadPool::worker_loop(int thread_index) {
+    uint64_t last_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_cv.wait(lock, [&]() { return quit || job_generation != last_generation; });
+            if (quit) return;
+            last_generation = job_generation;
+        }
+
+        run_chunks(thread_index);
+
+        bool last_one;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            last_one = (--busy_workers == 0);
+        }
+        if (last_one) {
+            done_cv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::run_chunks(int thread_index) {
+    ZoneScopedN("ThreadPool Job")
+    while (true) {
+        int chunk = next_chunk.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= job_num_chunks) break;
+        (*job_fun)(chunk, thread_index);
+    }
+}
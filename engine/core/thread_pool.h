@@ -0,0 +1,51 @@
+//
+// Created by lasagnaphil on 10/17/2026.
+//
+
+#ifndef THESYSTEM_THREAD_POOL_H
+#define THESYSTEM_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small fork-join thread pool for data-parallel loops.
+// Work is split into chunks, and idle threads keep grabbing the next unclaimed chunk
+// from a shared counter, so uneven chunks get balanced across threads.
+class ThreadPool {
+public:
+    // num_threads includes the calling thread (0 means use all hardware threads).
+    explicit ThreadPool(int num_threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads that can run a job (worker threads + calling thread).
+    int num_threads() const { return (int)workers.size() + 1; }
+
+    // Calls fun(chunk_index, thread_index) for every chunk in [0, num_chunks) and blocks until all are done.
+    // thread_index is in [0, num_threads()), and the calling thread always runs as thread 0.
+    void parallel_for(int num_chunks, const std::function<void(int, int)>& fun);
+
+private:
+    void worker_loop(int thread_index);
+    void run_chunks(int thread_index);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable job_cv;
+    std::condition_variable done_cv;
+    uint64_t job_generation = 0;
+    int busy_workers = 0;
+    bool quit = false;
+
+    const std::function<void(int, int)>* job_fun = nullptr;
+    int job_num_chunks = 0;
+    std::atomic<int> next_chunk = 0;
+};
+
+#endif //THESYSTEM_THREAD_POOL_H
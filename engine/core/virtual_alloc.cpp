@@ -23,6 +23,7 @@
 #include <cassert>
 
 #include "core/windows_utils.h"
+#include "core/alloc_tracker.h"
 
 void* virtual_alloc(std::size_t num_bytes)
 {
@@ -77,6 +78,7 @@ void virtual_commit(void* offset, std::size_t num_bytes)
         std::abort();
     }
 #endif
+    alloc_track_commit(num_bytes);
 }
 
 void virtual_decommit(void* offset, std::size_t num_bytes)
@@ -92,6 +94,34 @@ void virtual_decommit(void* offset, std::size_t num_bytes)
     auto const result2 = ::mprotect(offset, num_bytes, PROT_NONE);
     (void)result2;
     assert(result2 == 0);
+#endif
+    alloc_track_decommit(num_bytes);
+}
+
+void virtual_reset(void* offset, std::size_t num_bytes)
+{
+    assert(num_bytes > 0);
+
+#ifdef _WIN32
+    auto const result = ::VirtualAlloc(offset, num_bytes, MEM_RESET, PAGE_READWRITE);
+    (void)result;
+    assert(result != nullptr);
+#else
+    auto const result = ::madvise(offset, num_bytes, MADV_DONTNEED);
+    (void)result;
+    assert(result == 0);
+#endif
+}
+
+void virtual_advise_huge_pages(void* offset, std::size_t num_bytes)
+{
+#if !defined(_WIN32) && defined(MADV_HUGEPAGE)
+    // Only a hint, transparent huge pages may be disabled system-wide
+    ::madvise(offset, num_bytes, MADV_HUGEPAGE);
+#else
+    // Large pages on Windows need SeLockMemoryPrivilege, so don't bother
+    (void)offset;
+    (void)num_bytes;
 #endif
 }
 
@@ -101,6 +131,6 @@ std::size_t virtual_page_size = []{
     ::GetSystemInfo(&info);
     return static_cast<std::size_t>(info.dwPageSize);
 #else
-    static_cast<std::size_t>(::getpagesize());
+    return static_cast<std::size_t>(::getpagesize());
 #endif
 }();
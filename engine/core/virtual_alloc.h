@@ -12,4 +12,13 @@ void virtual_commit(void* offset, std::size_t num_bytes);
 
 void virtual_decommit(void* offset, std::size_t num_bytes);
 
+// Lets the OS drop the physical pages of a committed range, which stays accessible: it reads back as zeros
+// (or as the old contents on Windows) until it gets written again. Doesn't count as a decommit.
+// On Windows (MEM_RESET) the pages only get dropped once the OS needs the memory, so the working set
+// doesn't shrink right away.
+void virtual_reset(void* offset, std::size_t num_bytes);
+
+// Asks the OS to back the range with huge pages (transparent huge pages on Linux, no-op elsewhere).
+void virtual_advise_huge_pages(void* offset, std::size_t num_bytes);
+
 extern std::size_t virtual_page_size;
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include "sound.h"
 #include "core/log.h"
 #include "core/color.h"
+#include "core/thread_pool.h"
+#include "core/alloc_tracker.h"
 #include "render/tilemap.h"
 #include "render/camera.h"
 #include "render/font.h"
@@ -28,6 +30,9 @@
 #include "sokol/sokol_impl.h"
 
 #include <Tracy.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include <fstream>
 
 #ifdef _WIN32
@@ -47,6 +52,7 @@ void Engine::push_scene(const char* scene_script_path) {
     Scene scene(this, scene_script_path);
     scene.load();
     scene_stack.push_back(scene);
+    alloc_budget_skip_frames = alloc_budget_warmup_frames;
 }
 
 void sapp_init_cb() {
@@ -164,6 +170,27 @@ void Engine::base_pre_init() {
 
 #endif
 
+    if (const char* budget = std::getenv("THESYSTEM_ALLOC_BUDGET")) {
+        char* end;
+        long long value = std::strtoll(budget, &end, 10);
+        if (end == budget || *end != '\0' || value < 0) {
+            log_warn("THESYSTEM_ALLOC_BUDGET should be a non-negative number of allocations, got \"{}\".", budget);
+        }
+        else {
+            alloc_budget = value;
+        }
+        if (!alloc_tracking_enabled) {
+            log_warn("THESYSTEM_ALLOC_BUDGET is set, but the engine was built without THESYSTEM_TRACK_ALLOCATIONS.");
+        }
+    }
+    if (const char* warmup = std::getenv("THESYSTEM_ALLOC_BUDGET_WARMUP")) {
+        alloc_budget_warmup_frames = std::max(std::atoi(warmup), 0);
+    }
+    if (const char* fatal = std::getenv("THESYSTEM_ALLOC_BUDGET_FATAL")) {
+        alloc_budget_fatal = std::strcmp(fatal, "0") != 0;
+    }
+    alloc_budget_skip_frames = alloc_budget_warmup_frames;
+
     // Initialize resource pools
     res = std::make_unique<Resources>();
 
@@ -211,12 +238,15 @@ void Engine::base_init() {
 
     // Initialize sprite renderer
     // Initialize tilemap renderer
-    sprite_renderer = std::make_unique<SpriteRenderer>();
+    sprite_renderer = std::make_unique<SpriteRenderer>(compact_sprite_vertices, instanced_sprites);
     sprite_renderer->init(this);
 
     // Initialize camera
     camera = std::make_unique<Camera>(game_width, game_height);
 
+    // Initialize worker threads
+    thread_pool = std::make_unique<ThreadPool>();
+
     collision_manager = std::make_unique<CollisionManager>(32);
 
     // Register APIs
@@ -271,9 +301,14 @@ void Engine::base_update(double dt) {
     measured_avg_dt /= past_measured_dts.size();
     measured_avg_fps = int(round(1.0 / measured_avg_dt));
 
+    frame_alloc.next_frame();
+    alloc_next_frame();
+    check_alloc_budget();
+
     if (needs_reload) {
         scene_stack.back().reload();
         needs_reload = false;
+        alloc_budget_skip_frames = alloc_budget_warmup_frames;
     }
 
     const int width = sapp_width(), height = sapp_height();
@@ -295,9 +330,14 @@ void Engine::base_update(double dt) {
     res->foreach<Animation>([dt](Animation& anim) {
         anim.update(dt);
     });
-    res->scriptable_update(dt);
+    {
+        AllocScope alloc_scope(AllocTag::Script);
+        res->scriptable_update(dt);
+    }
 
     collision_manager->update();
+    res->sync_pools();
+    res->plot_pool_stats();
 
     input->after_update();
 
@@ -314,11 +354,132 @@ void Engine::base_update(double dt) {
                 ImGui::MenuItem("Calls", 0, &sg_imgui.capture.open);
                 ImGui::EndMenu();
             }
+            if (ImGui::BeginMenu("Resources")) {
+                ImGui::MenuItem("Pool Stats", 0, &show_pool_stats);
+                ImGui::EndMenu();
+            }
+            if (ImGui::BeginMenu("Memory")) {
+                ImGui::MenuItem("Allocations", 0, &show_alloc_stats);
+                ImGui::EndMenu();
+            }
             ImGui::EndMainMenuBar();
         }
     }
 
     sg_imgui_draw(&sg_imgui);
+    if (show_pool_stats) {
+        draw_pool_stats();
+    }
+    if (show_alloc_stats) {
+        draw_alloc_stats();
+    }
+}
+
+void Engine::draw_pool_stats() {
+    if (!ImGui::Begin("Resource Pools", &show_pool_stats)) {
+        ImGui::End();
+        return;
+    }
+    auto pool_stats = res->get_pool_stats();
+    if (ImGui::BeginTable("pools", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Pool");
+        ImGui::TableSetupColumn("Live");
+        ImGui::TableSetupColumn("Slots");
+        ImGui::TableSetupColumn("Free");
+        ImGui::TableSetupColumn("Frag");
+        ImGui::TableSetupColumn("Committed");
+        ImGui::TableSetupColumn("Resident");
+        ImGui::TableSetupColumn("Reserved");
+        ImGui::TableHeadersRow();
+        for (auto& [name, stats] : pool_stats) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(name);
+            if (ImGui::IsItemHovered() && !stats.label_counts.empty()) {
+                ImGui::BeginTooltip();
+                for (auto [label, count] : stats.label_counts) {
+                    ImGui::Text("label %08X: %u", label, count);
+                }
+                ImGui::EndTooltip();
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.max_count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.free_count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f%%", 100.0f * stats.fragmentation());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f KB", stats.committed_bytes / 1024.0f);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f KB", stats.resident_bytes / 1024.0f);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f MB", stats.reserved_bytes / (1024.0f * 1024.0f));
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void Engine::draw_alloc_stats() {
+    if (!ImGui::Begin("Allocations", &show_alloc_stats)) {
+        ImGui::End();
+        return;
+    }
+    if (!alloc_tracking_enabled) {
+        ImGui::TextDisabled("Heap tracking is off (build with THESYSTEM_TRACK_ALLOCATIONS)");
+    }
+    ImGui::Text("Virtual committed: %.1f MB", alloc_get_committed_bytes() / (1024.0f * 1024.0f));
+    ImGui::Text("Allocations last frame: %llu", (unsigned long long)alloc_get_frame_allocs());
+    if (ImGui::BeginTable("allocs", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Subsystem");
+        ImGui::TableSetupColumn("Live");
+        ImGui::TableSetupColumn("Frame Allocs");
+        ImGui::TableSetupColumn("Frame Bytes");
+        ImGui::TableSetupColumn("Total Allocs");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < (int)AllocTag::Count; i++) {
+            AllocStats stats = alloc_get_stats((AllocTag)i);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(alloc_tag_name((AllocTag)i));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f KB", stats.live_bytes / 1024.0f);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats.frame_allocs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats.frame_bytes);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats.total_allocs);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void Engine::check_alloc_budget() {
+    uint64_t frame_allocs = alloc_get_frame_allocs();
+    TracyPlot("Frame Allocations", (int64_t)frame_allocs);
+    if (alloc_budget < 0) return;
+    // Loading a scene and filling up the scratch buffers allocate a lot, so only check once things settled
+    if (alloc_budget_skip_frames > 0) {
+        alloc_budget_skip_frames--;
+        return;
+    }
+    if (frame_allocs <= (uint64_t)alloc_budget) return;
+
+    log_error("Frame allocated {} times (budget {})", frame_allocs, alloc_budget);
+    for (int i = 0; i < (int)AllocTag::Count; i++) {
+        AllocStats stats = alloc_get_stats((AllocTag)i);
+        if (stats.frame_allocs > 0) {
+            log_error("    {}: {} allocs, {} bytes", alloc_tag_name((AllocTag)i), stats.frame_allocs, stats.frame_bytes);
+        }
+    }
+    if (alloc_budget_fatal) {
+        log_error("Aborting, since THESYSTEM_ALLOC_BUDGET_FATAL is set");
+        std::abort();
+    }
 }
 
 void Engine::base_event(const sapp_event* ev) {
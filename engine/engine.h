@@ -8,6 +8,7 @@
 #include "scene.h"
 
 #include "core/rect.h"
+#include "core/arena_allocator.h"
 
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -23,6 +24,7 @@ class Sound;
 class Camera;
 class SpriteRenderer;
 class CollisionManager;
+class ThreadPool;
 
 class Engine {
 public:
@@ -54,6 +56,9 @@ public:
     SpriteRenderer* get_sprite_renderer() { return sprite_renderer.get(); }
     Camera* get_camera() { return camera.get(); }
     CollisionManager* get_collision_manager() { return collision_manager.get(); }
+    ThreadPool* get_thread_pool() { return thread_pool.get(); }
+    // Scratch memory for the current frame (valid until the end of the next one). Main thread only.
+    arena_allocator& get_frame_allocator() { return frame_alloc.get(); }
 
     int get_fps() { return measured_avg_fps; }
 
@@ -81,12 +86,30 @@ protected:
 
     sg_imgui_t sg_imgui;
     bool show_debug_menu = false;
+    bool show_pool_stats = false;
+    void draw_pool_stats();
+    bool show_alloc_stats = false;
+    void draw_alloc_stats();
+
+    // Max heap allocations per frame (THESYSTEM_ALLOC_BUDGET env var, for headless CI runs), -1 if unchecked.
+    // Frames right after a scene loads are skipped (THESYSTEM_ALLOC_BUDGET_WARMUP, in frames),
+    // and THESYSTEM_ALLOC_BUDGET_FATAL=1 aborts when going over the budget so the run fails.
+    int64_t alloc_budget = -1;
+    int alloc_budget_warmup_frames = 60;
+    int alloc_budget_skip_frames = 0;
+    bool alloc_budget_fatal = false;
+    void check_alloc_budget();
 
     bool needs_reload = false;
 
     int window_size_multiplier = 1;
     int game_width = 640;
     int game_height = 480;
+    // Smaller sprite vertices, set in pre_init(). Positions are limited to +-COMPACT_POS_RANGE (8192) pixels
+    // around the view center (tile layers aren't limited), sprites further away get clamped with a warning.
+    bool compact_sprite_vertices = false;
+    // Draw sprites with GPU instancing (one record per sprite instead of 4 vertices), set in pre_init()
+    bool instanced_sprites = false;
     irect viewport_rect;
 
     std::unique_ptr<VM> sqvm;
@@ -96,6 +119,9 @@ protected:
     std::unique_ptr<Camera> camera;
     std::unique_ptr<SpriteRenderer> sprite_renderer;
     std::unique_ptr<CollisionManager> collision_manager;
+    std::unique_ptr<ThreadPool> thread_pool;
+
+    frame_arena frame_alloc = frame_arena(1024 * 1024, "Frame");
 
     std::vector<Scene> scene_stack;
 
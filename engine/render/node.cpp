@@ -3,6 +3,7 @@
 #include "engine.h"
 #include "resources.h"
 #include "squirrel/vm.h"
+#include "collision/collision_manager.h"
 
 #include <Tracy.hpp>
 
@@ -58,7 +59,7 @@ void Node::set_parent(Ref<Node> parent_ref) {
     assert(self.check());
     parent_ref.get()->children.push_back(self);
     this->parent = parent_ref;
-    this->_global_xform_dirty = true;
+    _notify_transform();
 }
 
 void Node::add_child(Ref<Node> child_ref) {
@@ -66,7 +67,7 @@ void Node::add_child(Ref<Node> child_ref) {
     assert(self.check());
     auto child = child_ref.get();
     child->parent = self;
-    child->_global_xform_dirty = true;
+    child->_notify_transform();
     children.push_back(child_ref);
 }
 
@@ -76,7 +77,7 @@ void Node::remove_child(Ref<Node> child_ref) {
         children.erase(it);
         auto child = child_ref.get();
         child->parent = {};
-        child->_global_xform_dirty = true;
+        child->_notify_transform();
     }
     else {
         log_warn("Trying to remove invalid child!");
@@ -101,6 +102,12 @@ void Node::_notify_transform() {
     if (_global_xform_dirty) return;
 
     _global_xform_dirty = true;
+    if (_is_collider) {
+        auto col_mgr = Engine::instance().get_collision_manager();
+        if (col_mgr) {
+            col_mgr->notify_transform(get_self().cast_unsafe<Collider>());
+        }
+    }
     for (auto child_ref : children) {
         child_ref.get()->_notify_transform();
     }
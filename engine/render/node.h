@@ -53,6 +53,9 @@ protected:
     mutable bool _xform_dirty = true;
     mutable bool _global_xform_dirty = true;
 
+    // Colliders report transform changes to the CollisionManager
+    bool _is_collider = false;
+
 public:
     friend class Collider;
 
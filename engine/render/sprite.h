@@ -14,7 +14,7 @@
 #include "squirrel/object.h"
 #include "render/node.h"
 
-CLASS(Resource) Sprite : public Node {
+CLASS(Resource, Concurrent) Sprite : public Node {
 public:
     CLASS(OptionFor=Sprite) Options : public Node::Options {
     public:
@@ -58,6 +58,12 @@ public:
     void set_origin(vec2 _origin) { origin = _origin; }
     FUNCTION(setter)
     void set_color(rgba _color) { color = _color; }
+
+private:
+    // Where SpriteRenderer keeps this sprite in its render queue (only valid if _queued_ref is the sprite's own ref,
+    // so copies and reused slots count as new sprites)
+    Ref<Sprite> _queued_ref;
+    uint32_t _queue_pos = 0;
 };
 
 #endif //THESYSTEM_SPRITE_H
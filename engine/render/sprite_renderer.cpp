@@ -10,185 +10,343 @@
 #include "camera.h"
 #include "engine.h"
 #include "core/timer.h"
+#include "core/alloc_tracker.h"
+#include "core/radix_sort.h"
 #include "render/animation.h"
+#include "render/tilemap.h"
 
 #include <algorithm>
 
+#include <glm/matrix.hpp>
+
 #include <Tracy.hpp>
 
 inline uint64_t get_sprite_order_id(uint32_t texture_id, uint16_t layer, uint16_t order) {
     return ((uint64_t)layer << 48) | ((uint64_t)order << 32) | texture_id;
 }
 
+// Below this, std::sort beats the fixed cost of the radix sort histograms
+static constexpr size_t radix_sort_min_sprites = 256;
+
 void SpriteRenderer::init(Engine* engine) {
     ZoneScoped
     shader = sg_make_shader(sprite_shader_desc(sg_query_backend()));
 
+    sg_layout_desc layout = {};
+    if (compact_vertices) {
+        layout.attrs[0].format = SG_VERTEXFORMAT_SHORT2N;
+        layout.attrs[1].format = SG_VERTEXFORMAT_USHORT2N;
+        layout.attrs[2].format = SG_VERTEXFORMAT_UBYTE4N;
+    }
+    else {
+        layout.attrs[0].format = SG_VERTEXFORMAT_FLOAT2;
+        layout.attrs[1].format = SG_VERTEXFORMAT_FLOAT2;
+        layout.attrs[2].format = SG_VERTEXFORMAT_UBYTE4N;
+    }
+
+    sg_color_state color_state = {
+        .blend = {
+            .enabled = true,
+            .src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA,
+            .dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+            .op_rgb = SG_BLENDOP_ADD,
+            .src_factor_alpha = SG_BLENDFACTOR_SRC_ALPHA,
+            .dst_factor_alpha = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+            .op_alpha = SG_BLENDOP_ADD,
+        }
+    };
+
     pipeline = sg_make_pipeline(sg_pipeline_desc {
         .shader = shader,
-        .layout = {
-            .attrs = {
-                {.format = SG_VERTEXFORMAT_FLOAT2},
-                {.format = SG_VERTEXFORMAT_FLOAT2},
-                {.format = SG_VERTEXFORMAT_UBYTE4N},
-            }
-        },
-        .colors = {
-            {
-                .blend = {
-                    .enabled = true,
-                    .src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA,
-                    .dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
-                    .op_rgb = SG_BLENDOP_ADD,
-                    .src_factor_alpha = SG_BLENDFACTOR_SRC_ALPHA,
-                    .dst_factor_alpha = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
-                    .op_alpha = SG_BLENDOP_ADD,
-                }
-            }
-        },
+        .layout = layout,
+        .colors = {color_state},
+        .index_type = SG_INDEXTYPE_UINT32,
         .label = "SpriteRenderer",
     });
 
+    // Every quad is 4 vertices, so the indices never change (4 * MAX_SPRITES vertices don't fit in 16 bits)
+    std::vector<uint32_t> indices(6 * MAX_SPRITES);
+    for (uint32_t i = 0; i < MAX_SPRITES; i++) {
+        indices[6*i + 0] = 4*i + 0;
+        indices[6*i + 1] = 4*i + 1;
+        indices[6*i + 2] = 4*i + 2;
+        indices[6*i + 3] = 4*i + 1;
+        indices[6*i + 4] = 4*i + 3;
+        indices[6*i + 5] = 4*i + 2;
+    }
+
     bindings = {};
-    bindings.vertex_buffers[0] = sg_make_buffer(sg_buffer_desc {
-        .size = 6*sizeof(SpriteVertex)*MAX_SPRITES,
-        .usage = SG_USAGE_STREAM,
+    if (!instanced) {
+        size_t vertex_size = compact_vertices? sizeof(CompactSpriteVertex) : sizeof(SpriteVertex);
+        bindings.vertex_buffers[0] = sg_make_buffer(sg_buffer_desc {
+            .size = 4*vertex_size*MAX_SPRITES,
+            .usage = SG_USAGE_STREAM,
+        });
+    }
+    bindings.index_buffer = sg_make_buffer(sg_buffer_desc {
+        .type = SG_BUFFERTYPE_INDEXBUFFER,
+        .data = {indices.data(), indices.size() * sizeof(uint32_t)},
+        .label = "SpriteRenderer quad indices",
     });
+
+    if (instanced) {
+        instanced_shader = sg_make_shader(sprite_instanced_shader_desc(sg_query_backend()));
+
+        sg_layout_desc instanced_layout = {};
+        instanced_layout.buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE;
+        instanced_layout.attrs[ATTR_vs_instanced_a_corner] = {.buffer_index = 0, .format = SG_VERTEXFORMAT_FLOAT2};
+        instanced_layout.attrs[ATTR_vs_instanced_i_axes] = {.buffer_index = 1, .format = SG_VERTEXFORMAT_FLOAT4};
+        instanced_layout.attrs[ATTR_vs_instanced_i_pos] = {.buffer_index = 1, .format = SG_VERTEXFORMAT_FLOAT2};
+        instanced_layout.attrs[ATTR_vs_instanced_i_uv_rect] = {.buffer_index = 1, .format = SG_VERTEXFORMAT_USHORT4N};
+        instanced_layout.attrs[ATTR_vs_instanced_i_color] = {.buffer_index = 1, .format = SG_VERTEXFORMAT_UBYTE4N};
+
+        instanced_pipeline = sg_make_pipeline(sg_pipeline_desc {
+            .shader = instanced_shader,
+            .layout = instanced_layout,
+            .colors = {color_state},
+            .index_type = SG_INDEXTYPE_UINT32,
+            .label = "SpriteRenderer instanced",
+        });
+
+        // Same corner order as rect::v0() - v3(), so the first 6 quad indices cover it
+        vec2 corners[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}};
+        instanced_bindings = {};
+        instanced_bindings.vertex_buffers[0] = sg_make_buffer(sg_buffer_desc {
+            .data = SG_RANGE(corners),
+            .label = "SpriteRenderer quad corners",
+        });
+        instanced_bindings.vertex_buffers[1] = sg_make_buffer(sg_buffer_desc {
+            .size = sizeof(SpriteInstance)*MAX_SPRITES,
+            .usage = SG_USAGE_STREAM,
+            .label = "SpriteRenderer instances",
+        });
+        instanced_bindings.index_buffer = bindings.index_buffer;
+    }
 }
 
-void SpriteRenderer::draw(Engine* engine) {
+void SpriteRenderer::update_render_queue(Engine* engine) {
     ZoneScoped
     auto res = engine->get_resources();
-    auto& sprites = res->get_pool<Sprite>();
     auto& textures = res->get_pool<Texture>();
-    if (sprites.size() == 0) return;
+    auto& frame_alloc = engine->get_frame_allocator();
 
-    auto camera = engine->get_camera();
-    struct SpriteEntry {
-        Ref<Sprite> sprite_ref;
-        uint64_t sprite_order_id;
-    };
-    std::vector<SpriteEntry> sorted_sprites;
-    sorted_sprites.reserve(sprites.size());
+    // Released sprites are never touched again (their memory might be decommitted already),
+    // entries that no live sprite claims this frame just get dropped.
+    arena_vector<uint8_t> keep(render_queue.size(), 0, &frame_alloc);
+    arena_vector<QueueEntry> changed(&frame_alloc);
 
     res->foreach_ref<Sprite>([&](Ref<Sprite> sprite_ref, Sprite& sprite) {
-        if (!sprite.is_render_enabled()) return;
-        SpriteEntry entry;
+        if (sprite._queued_ref == sprite_ref) {
+            assert(sprite._queue_pos < render_queue.size());
+            auto& entry = render_queue[sprite._queue_pos];
+            if (entry.tex_ref == sprite.tex_ref &&
+                (uint16_t)(entry.sprite_order_id >> 48) == sprite.layer &&
+                (uint16_t)(entry.sprite_order_id >> 32) == sprite.z_index) {
+                keep[sprite._queue_pos] = 1;
+                return;
+            }
+        }
+        QueueEntry entry;
         entry.sprite_ref = sprite_ref;
+        entry.tex_ref = sprite.tex_ref;
         uint32_t texture_index = textures.get_index(sprite.tex_ref);
         entry.sprite_order_id = get_sprite_order_id(texture_index, sprite.layer, sprite.z_index);
-        sorted_sprites.push_back(entry);
+        changed.push_back(entry);
     });
 
-    {
-        ZoneScopedN("Sprite Sorting")
+    size_t kept = 0;
+    for (size_t i = 0; i < render_queue.size(); i++) {
+        if (keep[i]) {
+            render_queue[kept++] = render_queue[i];
+        }
+    }
+    if (kept == render_queue.size() && changed.empty()) return;
+    render_queue.resize(kept);
 
-        std::sort(sorted_sprites.begin(), sorted_sprites.end(), [](const SpriteEntry& e1, const SpriteEntry& e2) {
+    if (!changed.empty()) {
+        auto compare = [](const QueueEntry& e1, const QueueEntry& e2) {
             return e1.sprite_order_id < e2.sprite_order_id;
-        });
+        };
+        {
+            ZoneScopedN("Sprite Sorting")
+            if (changed.size() < radix_sort_min_sprites) {
+                std::sort(changed.begin(), changed.end(), compare);
+            }
+            else {
+                auto scratch = static_cast<QueueEntry*>(
+                        frame_alloc.allocate(changed.size() * sizeof(QueueEntry), alignof(QueueEntry), 0));
+                radix_sort(changed.data(), scratch, changed.size(), [](const QueueEntry& e) {
+                    return e.sprite_order_id;
+                });
+            }
+        }
+        merged_queue.resize(render_queue.size() + changed.size());
+        std::merge(render_queue.begin(), render_queue.end(), changed.begin(), changed.end(),
+                   merged_queue.begin(), compare);
+        std::swap(render_queue, merged_queue);
+    }
+
+    for (uint32_t i = 0; i < render_queue.size(); i++) {
+        auto sprite = render_queue[i].sprite_ref.get();
+        sprite->_queued_ref = render_queue[i].sprite_ref;
+        sprite->_queue_pos = i;
     }
+}
+
+template <class EmitFn>
+void SpriteRenderer::generate_batches(EmitFn&& emit, arena_vector<int>& texture_change_indices,
+                                      arena_vector<Ref<Texture>>& render_textures,
+                                      arena_vector<uint64_t>& render_order_ids) {
+    uint64_t cur_sprite_order_id = -1;
+    int sprite_count = 0;
+    for (auto& entry : render_queue) {
+        auto& sprite = *entry.sprite_ref.get();
+        if (!sprite.is_render_enabled()) continue;
+        if (cur_sprite_order_id != entry.sprite_order_id) {
+            cur_sprite_order_id = entry.sprite_order_id;
+            texture_change_indices.push_back(sprite_count);
+            render_textures.push_back(sprite.tex_ref);
+            render_order_ids.push_back(entry.sprite_order_id);
+        }
+        sprite_count++;
+
+        auto& tex = *sprite.tex_ref.get();
+        auto tex_info = sg_query_image_info(tex.img);
+        vec2 tex_size = {tex_info.width, tex_info.height};
+        emit(sprite, tex_size);
+    }
+    texture_change_indices.push_back(sprite_count);
+}
+
+void SpriteRenderer::draw(Engine* engine) {
+    ZoneScoped
+    AllocScope alloc_scope(AllocTag::Render);
+
+    update_render_queue(engine);
+
+    auto res = engine->get_resources();
+    auto camera = engine->get_camera();
+    auto& frame_alloc = engine->get_frame_allocator();
+
+    // Baked tile layers get drawn in between the sprite batches, before the sprites of the same layer and z_index
+    arena_vector<TileLayer*> tile_layers(&frame_alloc);
+    res->foreach<Tilemap>([&](Tilemap& tilemap) {
+        for (auto& tile_layer : tilemap.tile_layers) {
+            tile_layer.upload();
+            tile_layers.push_back(&tile_layer);
+        }
+    });
+    std::sort(tile_layers.begin(), tile_layers.end(), [](const TileLayer* l1, const TileLayer* l2) {
+        // (Layers of one tilemap are contiguous, so the address keeps their load order)
+        return l1->get_order_id() < l2->get_order_id() ||
+            (l1->get_order_id() == l2->get_order_id() && l1 < l2);
+    });
+
+    if (render_queue.empty() && tile_layers.empty()) return;
 
     mat4 model_mat = camera->get_model_mat();
     mat4 proj_mat = camera->get_proj_mat();
     mat4 trans_mat = model_mat * proj_mat;
+    // Quads are pushed relative to the view center, so compact vertices cover the area around the view
+    vec2 view_center = vec2(glm::inverse(trans_mat) * vec4(0.0f, 0.0f, 0.0f, 1.0f));
 
-    std::vector<int> texture_change_indices;
-    std::vector<Ref<Texture>> render_textures;
+    arena_vector<int> texture_change_indices(&frame_alloc);
+    arena_vector<Ref<Texture>> render_textures(&frame_alloc);
+    arena_vector<uint64_t> render_order_ids(&frame_alloc);
 
     {
         ZoneScopedN("Generate VBO Mesh")
-
-        vertices.reserve(sorted_sprites.size() * 6);
-        for (auto& entry : sorted_sprites) {
-            auto& sprite = *entry.sprite_ref.get();
-            auto& tex = *sprite.tex_ref.get();
-            auto tex_info = sg_query_image_info(tex.img);
-            vec2 tex_size = {tex_info.width, tex_info.height};
-            trans2d trans = sprite.get_global_trans();
-            rect local_rect = {-sprite.origin, sprite.srcrect.size};
-            vec2 v0 = trans.xform(local_rect.v0());
-            vec2 v1 = trans.xform(local_rect.v1());
-            vec2 v2 = trans.xform(local_rect.v2());
-            vec2 v3 = trans.xform(local_rect.v3());
-            {
-                SpriteVertex vertex;
-                vertex.pos = v0;
-                vertex.uv = vec2(sprite.srcrect.v0()) / tex_size;
-                vertex.color = sprite.color;
-                vertices.push_back(vertex);
-            }
-            {
-                SpriteVertex vertex;
-                vertex.pos = v1;
-                vertex.uv = vec2(sprite.srcrect.v1()) / tex_size;
-                vertex.color = sprite.color;
-                vertices.push_back(vertex);
-            }
-            {
-                SpriteVertex vertex;
-                vertex.pos = v2;
-                vertex.uv = vec2(sprite.srcrect.v2()) / tex_size;
-                vertex.color = sprite.color;
-                vertices.push_back(vertex);
-            }
-            {
-                SpriteVertex vertex;
-                vertex.pos = v1;
-                vertex.uv = vec2(sprite.srcrect.v1()) / tex_size;
-                vertex.color = sprite.color;
-                vertices.push_back(vertex);
-            }
-            {
-                SpriteVertex vertex;
-                vertex.pos = v3;
-                vertex.uv = vec2(sprite.srcrect.v3()) / tex_size;
-                vertex.color = sprite.color;
-                vertices.push_back(vertex);
-            }
-            {
-                SpriteVertex vertex;
-                vertex.pos = v2;
-                vertex.uv = vec2(sprite.srcrect.v2()) / tex_size;
-                vertex.color = sprite.color;
-                vertices.push_back(vertex);
-            }
+        auto emit_quad = [view_center](auto& out_vertices) {
+            return [&out_vertices, view_center](Sprite& sprite, vec2 tex_size) {
+                trans2d trans = sprite.get_global_trans();
+                rect local_rect = {-sprite.origin, sprite.srcrect.size};
+                vec2 corners[4] = {
+                    trans.xform(local_rect.v0()),
+                    trans.xform(local_rect.v1()),
+                    trans.xform(local_rect.v2()),
+                    trans.xform(local_rect.v3()),
+                };
+                push_sprite_quad(out_vertices, corners, view_center, sprite.srcrect, tex_size, sprite.color);
+            };
+        };
+        if (instanced) {
+            instances.reserve(render_queue.size());
+            generate_batches([&](Sprite& sprite, vec2 tex_size) {
+                instances.push_back(make_sprite_instance(sprite.get_global_trans(), sprite.origin, sprite.srcrect,
+                                                         tex_size, sprite.color));
+            }, texture_change_indices, render_textures, render_order_ids);
         }
-
-        uint64_t cur_sprite_order_id = -1;
-        for (int i = 0; i < sorted_sprites.size(); i++) {
-            auto& entry = sorted_sprites[i];
-            if (cur_sprite_order_id != entry.sprite_order_id) {
-                cur_sprite_order_id = entry.sprite_order_id;
-                auto& sprite = *entry.sprite_ref.get();
-                texture_change_indices.push_back(i);
-                render_textures.push_back(sprite.tex_ref);
-            }
+        else if (compact_vertices) {
+            compact_vertex_data.reserve(render_queue.size() * 4);
+            generate_batches(emit_quad(compact_vertex_data), texture_change_indices, render_textures,
+                             render_order_ids);
+        }
+        else {
+            vertices.reserve(render_queue.size() * 4);
+            generate_batches(emit_quad(vertices), texture_change_indices, render_textures, render_order_ids);
         }
-        texture_change_indices.push_back(sorted_sprites.size());
-
     }
 
     {
         ZoneScopedN("GPU Render")
-        sg_apply_pipeline(pipeline);
-
         if (!vertices.empty()) {
             sg_update_buffer(bindings.vertex_buffers[0], {vertices.data(), sizeof(SpriteVertex)*vertices.size()});
         }
+        else if (!compact_vertex_data.empty()) {
+            sg_update_buffer(bindings.vertex_buffers[0],
+                             {compact_vertex_data.data(), sizeof(CompactSpriteVertex)*compact_vertex_data.size()});
+        }
+        else if (!instances.empty()) {
+            sg_update_buffer(instanced_bindings.vertex_buffers[1],
+                             {instances.data(), sizeof(SpriteInstance)*instances.size()});
+        }
 
-        vs_params.u_trans = trans_mat;
-        sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, {&vs_params, sizeof(vs_params)});
+        // Tile layers always use the vertex pipeline, so with instancing we switch back and forth
+        sg_pipeline cur_pipeline = {};
+        auto use_pipeline = [&](sg_pipeline pip) {
+            if (pip.id == cur_pipeline.id) return;
+            cur_pipeline = pip;
+            sg_apply_pipeline(pip);
+            // Vertices are relative to the view center (and normalized in compact mode), instances are in pixels
+            vs_params.u_trans = pip.id == pipeline.id?
+                    sprite_vertex_trans(trans_mat, view_center, compact_vertices) : trans_mat;
+            sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, {&vs_params, sizeof(vs_params)});
+        };
+
+        size_t next_tile_layer = 0;
+        auto draw_tile_layers_until = [&](uint64_t order_id) {
+            while (next_tile_layer < tile_layers.size() && tile_layers[next_tile_layer]->get_order_id() <= order_id) {
+                use_pipeline(pipeline);
+                tile_layers[next_tile_layer++]->draw(bindings, trans_mat, compact_vertices);
+                // Chunks apply their own u_trans, so the sprites have to apply theirs again
+                cur_pipeline = {};
+            }
+        };
 
         for (int i = 0; i < texture_change_indices.size() - 1; i++) {
+            draw_tile_layers_until(render_order_ids[i]);
             int start_idx = texture_change_indices[i];
             int end_idx = texture_change_indices[i+1];
             auto tex = render_textures[i].get();
-            bindings.fs_images[SLOT_u_tex] = tex->img;
-            sg_apply_bindings(bindings);
-            sg_draw(6*start_idx, 6*(end_idx - start_idx), 1);
+            if (instanced) {
+                // No base instance in sokol, so each batch offsets the instance buffer instead
+                use_pipeline(instanced_pipeline);
+                instanced_bindings.fs_images[SLOT_u_tex] = tex->img;
+                instanced_bindings.vertex_buffer_offsets[1] = start_idx * sizeof(SpriteInstance);
+                sg_apply_bindings(instanced_bindings);
+                sg_draw(0, 6, end_idx - start_idx);
+            }
+            else {
+                use_pipeline(pipeline);
+                bindings.fs_images[SLOT_u_tex] = tex->img;
+                sg_apply_bindings(bindings);
+                sg_draw(6*start_idx, 6*(end_idx - start_idx), 1);
+            }
         }
+        draw_tile_layers_until(UINT64_MAX);
     }
 
     vertices.clear();
+    compact_vertex_data.clear();
+    instances.clear();
 }
-
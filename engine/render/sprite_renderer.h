@@ -5,11 +5,15 @@
 #ifndef THESYSTEM_SPRITE_RENDERER_H
 #define THESYSTEM_SPRITE_RENDERER_H
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include "sprite.h"
 #include "camera.h"
 #include "core/color.h"
+#include "core/log.h"
+#include "core/arena_allocator.h"
 
 #include <sokol_gfx.h>
 
@@ -23,12 +27,105 @@ struct SpriteVertex {
     rgba color;
 };
 
+// Optional 12 byte vertex (instead of 20): positions as normalized shorts covering +-COMPACT_POS_RANGE pixels
+// (so 1/4 pixel precision), uvs as normalized ushorts. Positions are relative to an origin that goes into u_trans
+// (the view center for sprites, the chunk corner for tile layers), sprites further than that from the view get clamped.
+struct CompactSpriteVertex {
+    int16_t pos[2];
+    uint16_t uv[2];
+    rgba color;
+};
+
+static constexpr float COMPACT_POS_RANGE = 8192.0f;
+
+template <class Vertex>
+Vertex make_sprite_vertex(vec2 pos, vec2 uv, rgba color);
+
+template <>
+inline SpriteVertex make_sprite_vertex<SpriteVertex>(vec2 pos, vec2 uv, rgba color) {
+    return {pos, uv, color};
+}
+
+template <>
+inline CompactSpriteVertex make_sprite_vertex<CompactSpriteVertex>(vec2 pos, vec2 uv, rgba color) {
+    CompactSpriteVertex vertex;
+    if (std::abs(pos.x) > COMPACT_POS_RANGE || std::abs(pos.y) > COMPACT_POS_RANGE) {
+        static bool warned = false;
+        if (!warned) {
+            log_warn("Sprite vertex ({}, {}) is out of the compact vertex range (+-{} pixels from its origin), clamping it",
+                     pos.x, pos.y, COMPACT_POS_RANGE);
+            warned = true;
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        vertex.pos[i] = (int16_t)std::lround(std::clamp(pos[i] / COMPACT_POS_RANGE, -1.0f, 1.0f) * 32767.0f);
+        vertex.uv[i] = (uint16_t)std::lround(std::clamp(uv[i], 0.0f, 1.0f) * 65535.0f);
+    }
+    vertex.color = color;
+    return vertex;
+}
+
+// Appends the 4 corners of a quad (drawn with the index buffer of SpriteRenderer), relative to origin
+template <class Vertex>
+inline void push_sprite_quad(std::vector<Vertex>& vertices, const vec2 (&pos)[4], vec2 origin, irect srcrect,
+                             vec2 tex_size, rgba color) {
+    vertices.push_back(make_sprite_vertex<Vertex>(pos[0] - origin, vec2(srcrect.v0()) / tex_size, color));
+    vertices.push_back(make_sprite_vertex<Vertex>(pos[1] - origin, vec2(srcrect.v1()) / tex_size, color));
+    vertices.push_back(make_sprite_vertex<Vertex>(pos[2] - origin, vec2(srcrect.v2()) / tex_size, color));
+    vertices.push_back(make_sprite_vertex<Vertex>(pos[3] - origin, vec2(srcrect.v3()) / tex_size, color));
+}
+
+// u_trans for vertices pushed relative to origin (trans is the camera's model * projection matrix)
+inline mat4 sprite_vertex_trans(const mat4& trans, vec2 origin, bool compact) {
+    mat4 vertex_trans = trans * glm::translate(mat4(1.0f), vec3(origin, 0.0f));
+    if (compact) {
+        vertex_trans = vertex_trans * glm::scale(mat4(1.0f), vec3(COMPACT_POS_RANGE, COMPACT_POS_RANGE, 1.0f));
+    }
+    return vertex_trans;
+}
+
+// Per-sprite record of the instanced path, expanded into a quad by vs_instanced (36 bytes instead of 4 vertices)
+struct SpriteInstance {
+    // x and y axes of the global transform, scaled by the srcrect size
+    vec2 axes[2];
+    // Top-left corner of the quad (with the origin applied)
+    vec2 pos;
+    // u0, v0, u1, v1 as normalized ushorts
+    uint16_t uv_rect[4];
+    rgba color;
+};
+static_assert(sizeof(SpriteInstance) == 36, "SpriteInstance is uploaded as is");
+
+inline SpriteInstance make_sprite_instance(const trans2d& trans, vec2 origin, irect srcrect, vec2 tex_size,
+                                           rgba color) {
+    SpriteInstance instance;
+    instance.axes[0] = trans.basis_xform(vec2(srcrect.size.x, 0.0f));
+    instance.axes[1] = trans.basis_xform(vec2(0.0f, srcrect.size.y));
+    instance.pos = trans.xform(-origin);
+    vec2 uv0 = vec2(srcrect.v0()) / tex_size;
+    vec2 uv1 = vec2(srcrect.v3()) / tex_size;
+    float uvs[4] = {uv0.x, uv0.y, uv1.x, uv1.y};
+    for (int i = 0; i < 4; i++) {
+        instance.uv_rect[i] = (uint16_t)std::lround(std::clamp(uvs[i], 0.0f, 1.0f) * 65535.0f);
+    }
+    instance.color = color;
+    return instance;
+}
+
 class SpriteRenderer {
 public:
     static constexpr int MAX_SPRITES = 65536;
 
+    // instanced draws the sprites with sprite_instanced (one SpriteInstance each) instead of CPU generated quads,
+    // compact_vertices is still used for the tile layers then.
+    explicit SpriteRenderer(bool compact_vertices = false, bool instanced = false)
+            : compact_vertices(compact_vertices), instanced(instanced) {}
+
     void init(Engine* engine);
 
+    bool uses_compact_vertices() const { return compact_vertices; }
+    bool uses_instancing() const { return instanced; }
+
     void draw(Engine* engine);
 
 private:
@@ -38,7 +135,34 @@ private:
     vs_params_t vs_params;
     sg_bindings bindings;
 
+    bool compact_vertices;
     std::vector<SpriteVertex> vertices;
+    std::vector<CompactSpriteVertex> compact_vertex_data;
+
+    bool instanced;
+    sg_shader instanced_shader;
+    sg_pipeline instanced_pipeline;
+    // Quad corners (per vertex) and sprite instances (per instance), plus the quad index buffer
+    sg_bindings instanced_bindings;
+    std::vector<SpriteInstance> instances;
+
+    // Calls emit(sprite, tex_size) for every enabled sprite in the render queue, and splits them into batches
+    // of the same order id (texture_change_indices has the start of each batch, plus the total count)
+    template <class EmitFn>
+    void generate_batches(EmitFn&& emit, arena_vector<int>& texture_change_indices,
+                          arena_vector<Ref<Texture>>& render_textures, arena_vector<uint64_t>& render_order_ids);
+
+    struct QueueEntry {
+        Ref<Sprite> sprite_ref;
+        Ref<Texture> tex_ref;
+        uint64_t sprite_order_id;
+    };
+    // Sprites sorted by order id, kept between frames. Only new sprites and ones whose layer, z_index or texture
+    // changed get sorted and merged back in, so a static scene doesn't sort at all.
+    std::vector<QueueEntry> render_queue;
+    std::vector<QueueEntry> merged_queue;
+
+    void update_render_queue(Engine* engine);
 };
 
 #endif //THESYSTEM_SPRITE_RENDERER_H
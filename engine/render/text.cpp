@@ -7,6 +7,7 @@
 #include "sprite.h"
 #include "squirrel/vm.h"
 #include "squirrel/utils.h"
+#include "core/alloc_tracker.h"
 
 Text::Options::Options(sq::Table table) : Node::Options(table) {
     auto& engine = Engine::instance();
@@ -24,13 +25,10 @@ Text::Text(const Options &opt) : Node(opt) {
 
 void Text::update(float dt) {
     if (!is_dirty) return;
+    AllocScope alloc_scope(AllocTag::Text);
 
     auto res = Engine::instance().get_resources();
-    for (auto sprite : sprites) {
-        remove_child(sprite.cast_unsafe<Node>());
-        res->get_pool<Sprite>().release(sprite);
-    }
-    sprites.clear();
+    auto& sprite_pool = res->get_pool<Sprite>();
 
     // TODO: implement Unicode
     const auto& font = *font_ref.get();
@@ -53,9 +51,16 @@ void Text::update(float dt) {
             cy += space_height + 4;
             continue;
         }
-        auto sprite_ref = res->new_item<Sprite>();
-        add_child(sprite_ref.cast_unsafe<Node>());
-        sprites.push_back(sprite_ref);
+        // Reuse the glyph sprites of the previous contents, so changing the text doesn't churn the sprite pool
+        Ref<Sprite> sprite_ref;
+        if (counter < sprites.size()) {
+            sprite_ref = sprite_pool.get_ref(sprites[counter]);
+        }
+        else {
+            sprite_ref = res->new_item<Sprite>();
+            add_child(sprite_ref.cast_unsafe<Node>());
+            sprites.push_back(sprite_pool.get_handle(sprite_ref));
+        }
         uint32_t char_id = font.char_map.at((uint32_t)c);
         auto& ch = font.chars[char_id];
         auto sprite = sprite_ref.get();
@@ -76,5 +81,13 @@ void Text::update(float dt) {
         counter++;
     }
 
+    // Glyphs left over from longer contents get released at the end of the frame
+    for (int i = counter; i < sprites.size(); i++) {
+        Ref<Sprite> sprite = sprite_pool.get_ref(sprites[i]);
+        remove_child(sprite.cast_unsafe<Node>());
+        sprite_pool.release_deferred(sprite);
+    }
+    sprites.resize(counter);
+
     is_dirty = false;
 }
@@ -62,7 +62,7 @@ private:
     bool is_dirty = true;
 
     Ref<Font> font_ref;
-    std::vector<Ref<Sprite>> sprites;
+    std::vector<Handle<Sprite>> sprites;
 };
 
 #endif //THESYSTEM_TEXT_H
@@ -0,0 +1,186 @@
+//
+// Created by lasagnaphil on 10/17/2026.
+//
+
+#include "tile_layer.h"
+
+#include "texture.h"
+#include "sprite_renderer.h"
+#include "engine.h"
+#include "core/rect.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <glm/common.hpp>
+
+#include <Tracy.hpp>
+
+TileLayer::TileLayer(int width, int height, ivec2 tile_size, Ref<Texture> tex_ref, int tileset_columns,
+                     std::vector<int> tile_ids)
+        : width(width), height(height), tile_size(tile_size), tileset_columns(std::max(tileset_columns, 1)),
+          tex_ref(tex_ref), tiles(std::move(tile_ids)) {
+    assert(tiles.size() == width * height);
+    chunks_x = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunks_y = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunks.resize(chunks_x * chunks_y);
+}
+
+TileLayer::~TileLayer() {
+    release_chunks();
+}
+
+TileLayer::TileLayer(TileLayer&& other) noexcept {
+    *this = std::move(other);
+}
+
+TileLayer& TileLayer::operator=(TileLayer&& other) noexcept {
+    if (this == &other) return *this;
+    release_chunks();
+    layer = other.layer;
+    z_index = other.z_index;
+    render_enabled = other.render_enabled;
+    width = other.width;
+    height = other.height;
+    tile_size = other.tile_size;
+    tileset_columns = other.tileset_columns;
+    tex_ref = other.tex_ref;
+    chunks_x = other.chunks_x;
+    chunks_y = other.chunks_y;
+    tiles = std::move(other.tiles);
+    chunks = std::move(other.chunks);
+    has_dirty_chunks = other.has_dirty_chunks;
+    other.chunks.clear();
+    return *this;
+}
+
+void TileLayer::release_chunks() {
+    for (auto& chunk : chunks) {
+        if (chunk.buf.id != SG_INVALID_ID) {
+            sg_destroy_buffer(chunk.buf);
+            chunk.buf = {};
+        }
+    }
+}
+
+void TileLayer::set_tile(int x, int y, int tile_id) {
+    assert(x >= 0 && x < width && y >= 0 && y < height);
+    int& tile = tiles[y * width + x];
+    if (tile == tile_id) return;
+    tile = tile_id;
+
+    auto& chunk = chunks[(y / CHUNK_SIZE) * chunks_x + (x / CHUNK_SIZE)];
+    if (!chunk.dynamic && chunk.buf.id != SG_INVALID_ID) {
+        // Immutable buffers can't be updated, so recreate it as a dynamic one
+        sg_destroy_buffer(chunk.buf);
+        chunk.buf = {};
+    }
+    chunk.dynamic = true;
+    chunk.dirty = true;
+    has_dirty_chunks = true;
+}
+
+template <class Vertex>
+void TileLayer::build_chunk_vertices(int cx, int cy, vec2 tex_size, std::vector<Vertex>& vertices) const {
+    vec2 chunk_origin = vec2(cx, cy) * vec2(tile_size * CHUNK_SIZE);
+    int x_end = std::min((cx + 1) * CHUNK_SIZE, width);
+    int y_end = std::min((cy + 1) * CHUNK_SIZE, height);
+    for (int y = cy * CHUNK_SIZE; y < y_end; y++) {
+        for (int x = cx * CHUNK_SIZE; x < x_end; x++) {
+            int id = tiles[y * width + x];
+            if (id < 0) continue;
+
+            irect srcrect;
+            srcrect.pos = ivec2(id % tileset_columns, id / tileset_columns) * tile_size;
+            srcrect.size = tile_size;
+            rect dstrect = {vec2(x, y) * vec2(tile_size), vec2(tile_size)};
+            vec2 corners[4] = {dstrect.v0(), dstrect.v1(), dstrect.v2(), dstrect.v3()};
+            push_sprite_quad(vertices, corners, chunk_origin, srcrect, tex_size, 0xffffffff);
+        }
+    }
+}
+
+template <class Vertex>
+void TileLayer::upload_chunks() {
+    auto tex_info = sg_query_image_info(tex_ref.get()->img);
+    vec2 tex_size = {tex_info.width, tex_info.height};
+
+    std::vector<Vertex> vertices;
+    vertices.reserve(CHUNK_SIZE * CHUNK_SIZE * 4);
+    for (int cy = 0; cy < chunks_y; cy++) {
+        for (int cx = 0; cx < chunks_x; cx++) {
+            auto& chunk = chunks[cy * chunks_x + cx];
+            if (!chunk.dirty) continue;
+            chunk.dirty = false;
+
+            vertices.clear();
+            build_chunk_vertices(cx, cy, tex_size, vertices);
+            chunk.num_quads = vertices.size() / 4;
+
+            if (chunk.dynamic) {
+                if (chunk.buf.id == SG_INVALID_ID) {
+                    // Sized for a full chunk, so patching never has to grow it
+                    chunk.buf = sg_make_buffer(sg_buffer_desc {
+                        .size = CHUNK_SIZE * CHUNK_SIZE * 4 * sizeof(Vertex),
+                        .usage = SG_USAGE_DYNAMIC,
+                        .label = "TileLayer chunk",
+                    });
+                }
+                if (!vertices.empty()) {
+                    sg_update_buffer(chunk.buf, {vertices.data(), vertices.size() * sizeof(Vertex)});
+                }
+            }
+            else if (!vertices.empty()) {
+                chunk.buf = sg_make_buffer(sg_buffer_desc {
+                    .data = {vertices.data(), vertices.size() * sizeof(Vertex)},
+                    .label = "TileLayer chunk",
+                });
+            }
+        }
+    }
+}
+
+void TileLayer::upload() {
+    if (!has_dirty_chunks) return;
+    ZoneScoped
+
+    if (Engine::instance().get_sprite_renderer()->uses_compact_vertices()) {
+        upload_chunks<CompactSpriteVertex>();
+    }
+    else {
+        upload_chunks<SpriteVertex>();
+    }
+    has_dirty_chunks = false;
+}
+
+void TileLayer::draw(sg_bindings bindings, const mat4& trans, bool compact_vertices) const {
+    if (!render_enabled) return;
+    bindings.fs_images[SLOT_u_tex] = tex_ref.get()->img;
+
+    vec2 chunk_size = vec2(tile_size * CHUNK_SIZE);
+    for (int cy = 0; cy < chunks_y; cy++) {
+        for (int cx = 0; cx < chunks_x; cx++) {
+            auto& chunk = chunks[cy * chunks_x + cx];
+            if (chunk.num_quads == 0) continue;
+
+            // Skip chunks outside of the clip space box
+            rect bounds = {vec2(cx, cy) * chunk_size, chunk_size};
+            vec2 clip_min = vec2(INFINITY), clip_max = vec2(-INFINITY);
+            for (vec2 v : {bounds.v0(), bounds.v1(), bounds.v2(), bounds.v3()}) {
+                vec4 p = trans * vec4(v, 0.0f, 1.0f);
+                clip_min = glm::min(clip_min, vec2(p));
+                clip_max = glm::max(clip_max, vec2(p));
+            }
+            if (clip_max.x < -1.0f || clip_min.x > 1.0f || clip_max.y < -1.0f || clip_min.y > 1.0f) continue;
+
+            vs_params_t vs_params;
+            vs_params.u_trans = sprite_vertex_trans(trans, bounds.pos, compact_vertices);
+            sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, {&vs_params, sizeof(vs_params)});
+
+            bindings.vertex_buffers[0] = chunk.buf;
+            sg_apply_bindings(bindings);
+            sg_draw(0, 6 * chunk.num_quads, 1);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+//
+// Created by lasagnaphil on 10/17/2026.
+//
+
+#ifndef THESYSTEM_TILE_LAYER_H
+#define THESYSTEM_TILE_LAYER_H
+
+#include <vector>
+
+#include <sokol_gfx.h>
+
+#include "resource_pool.h"
+#include "core/types.h"
+
+class Texture;
+
+// A tile layer (of a single tileset) baked into vertex buffers of CHUNK_SIZE x CHUNK_SIZE tiles at load time.
+// SpriteRenderer draws it in (layer, z_index) order along with the sprites, so static tiles don't need
+// a Sprite each and cost no CPU vertex work per frame.
+class TileLayer {
+public:
+    static constexpr int CHUNK_SIZE = 32;
+
+    uint16_t layer = 0;
+    uint16_t z_index = 0;
+    bool render_enabled = true;
+
+    TileLayer() = default;
+    // tile_ids are indices into the tileset (row-major, width * height), -1 for empty tiles
+    TileLayer(int width, int height, ivec2 tile_size, Ref<Texture> tex_ref, int tileset_columns,
+              std::vector<int> tile_ids);
+    ~TileLayer();
+
+    // Owns GPU buffers
+    TileLayer(const TileLayer& other) = delete;
+    TileLayer& operator=(const TileLayer& other) = delete;
+    TileLayer(TileLayer&& other) noexcept;
+    TileLayer& operator=(TileLayer&& other) noexcept;
+
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+    Ref<Texture> get_texture() const { return tex_ref; }
+
+    int get_tile(int x, int y) const { return tiles[y * width + x]; }
+    // Patches a single tile (-1 to clear it). Its chunk gets re-uploaded before the next draw.
+    void set_tile(int x, int y, int tile_id);
+
+    // Sorts before the sprites on the same layer and z_index (same format as the sprite order ids)
+    uint64_t get_order_id() const { return ((uint64_t)layer << 48) | ((uint64_t)z_index << 32); }
+
+    // Creates or updates the buffers of new and patched chunks.
+    void upload();
+    // Draws the chunks that overlap the screen (trans is the camera's model * projection matrix).
+    // bindings should have everything but the vertex buffer and the texture set up (including the quad index buffer),
+    // and the SpriteRenderer pipeline has to be applied. Sets u_trans for every chunk.
+    void draw(sg_bindings bindings, const mat4& trans, bool compact_vertices) const;
+
+private:
+    struct Chunk {
+        sg_buffer buf = {};
+        int num_quads = 0;
+        bool dirty = true;
+        // Chunks start out immutable, a patched chunk gets recreated as a dynamic buffer
+        bool dynamic = false;
+    };
+
+    int width = 0, height = 0;
+    ivec2 tile_size = {0, 0};
+    int tileset_columns = 1;
+    Ref<Texture> tex_ref;
+
+    int chunks_x = 0, chunks_y = 0;
+    std::vector<int> tiles;
+    std::vector<Chunk> chunks;
+    bool has_dirty_chunks = true;
+
+    // In the vertex format of the SpriteRenderer, relative to the chunk corner (so compact vertices fit any map size)
+    template <class Vertex>
+    void upload_chunks();
+    template <class Vertex>
+    void build_chunk_vertices(int cx, int cy, vec2 tex_size, std::vector<Vertex>& vertices) const;
+    void release_chunks();
+};
+
+#endif //THESYSTEM_TILE_LAYER_H
@@ -10,6 +10,7 @@
 #include "core/file.h"
 #include "core/strparse.h"
 #include "core/log.h"
+#include "core/alloc_tracker.h"
 #include "render/texture.h"
 #include "squirrel/vm.h"
 #include "collision/collision_manager.h"
@@ -67,6 +68,15 @@ Ref<Tileset> Tileset::load(const char* filename) {
             opt.pos.x = node_object.attribute("x").as_int() + opt.aabb.extents.x;
             opt.pos.y = node_object.attribute("y").as_int() + opt.aabb.extents.y;
             opt.rot = 0;
+            for (auto node_property : node_object.child("properties").children("property")) {
+                auto prop_name = node_property.attribute("name").value();
+                if (strcmp(prop_name, "layer") == 0) {
+                    opt.layer = node_property.attribute("value").as_uint(opt.layer);
+                }
+                else if (strcmp(prop_name, "mask") == 0) {
+                    opt.mask = node_property.attribute("value").as_uint(opt.mask);
+                }
+            }
             obj.colliders.push_back(opt);
         }
         ts.objects.insert({id, obj});
@@ -275,11 +285,22 @@ Ref<Tilemap> Tilemap::load(const char* filename) {
 }
 
 void Tilemap::insert_to_scene() {
+    AllocScope alloc_scope(AllocTag::Tilemap);
     auto& engine = Engine::instance();
     auto vm = engine.get_vm();
     auto res = engine.get_resources();
     auto col_mgr = engine.get_collision_manager();
 
+    // Finite maps can use a dense grid for collision instead of the spatial hash
+    if (!infinite) {
+        AABB map_bounds;
+        map_bounds.min = vec2(0, 0);
+        map_bounds.max = vec2(width * tilewidth, height * tileheight);
+        col_mgr->set_bounds(map_bounds);
+    }
+
+    tile_layers.clear();
+
     for (auto& layer_group : layer_groups) {
         uint16_t layer_group_id;
         if (layer_group.name == "Background") {
@@ -308,6 +329,10 @@ void Tilemap::insert_to_scene() {
                 for (auto& tileset_ref : tilesets) {
                     auto& tileset = *tileset_ref.ref.get();
                     if (tileset.type != Tileset::Type::Image) continue;
+
+                    ivec2 tileset_size = ivec2(tileset.tilewidth, tileset.tileheight);
+                    std::vector<int> tile_ids(width * height, -1);
+                    bool has_tiles = false;
                     for (int y = 0; y < height; y++) {
                         for (int x = 0; x < width; x++) {
                             int idx = y * width + x;
@@ -316,32 +341,27 @@ void Tilemap::insert_to_scene() {
                                 layer.data[idx] < (tileset_ref.firstgid + tileset.tilecount)) {
 
                                 int id = layer.data[idx] - tileset_ref.firstgid;
-                                ivec2 tileset_size = ivec2(tileset.tilewidth, tileset.tileheight);
-                                ivec2 tileset_count = ivec2(tileset.columns, tileset.tilecount / tileset.columns);
-                                ivec2 index_pos = vec2(id % tileset_count.x, id / tileset_count.x);
-
-                                Sprite::Options opt;
-                                opt.srcrect.pos = index_pos * tileset_size;
-                                opt.srcrect.size = tileset_size;
-                                opt.pos = vec2(x * tileset.tilewidth, y * tileset.tileheight);
-                                opt.scale = vec2(1, 1);
-                                opt.origin = vec2(0, 0);
-                                opt.rot = 0;
-                                opt.color = rgba(0xffffffff);
-                                opt.layer = layer_group_id;
-                                opt.z_index = layer_id;
-                                opt.tex_ref = tileset.image_tex_ref;
-                                auto sprite_ref = res->new_item<Sprite>(opt);
-                                auto sprite = sprite_ref.get();
-
-                                auto& tsobj = tileset.objects[id];
-                                for (auto col_data : tsobj.colliders) {
-                                    auto col_ref = col_mgr->create_collider(col_data);
-                                    sprite->add_child(col_ref.cast_unsafe<Node>());
+                                tile_ids[idx] = id;
+                                has_tiles = true;
+
+                                // Tileset colliders are relative to their tile
+                                auto tsobj_it = tileset.objects.find(id);
+                                if (tsobj_it == tileset.objects.end()) continue;
+                                for (auto col_data : tsobj_it->second.colliders) {
+                                    col_data.is_static = true;
+                                    col_data.pos += vec2(ivec2(x, y) * tileset_size);
+                                    col_mgr->create_collider(col_data);
                                 }
                             }
                         }
                     }
+                    if (!has_tiles) continue;
+
+                    TileLayer tile_layer(width, height, tileset_size, tileset.image_tex_ref, tileset.columns,
+                                         std::move(tile_ids));
+                    tile_layer.layer = layer_group_id;
+                    tile_layer.z_index = layer_id;
+                    tile_layers.push_back(std::move(tile_layer));
                 }
             }
             else if (layer.type == TiledLayer::Type::ObjectGroup) {
@@ -15,6 +15,7 @@
 #include "core/color.h"
 
 #include "collision/collider.h"
+#include "render/tile_layer.h"
 
 class Engine;
 
@@ -146,6 +147,9 @@ public:
 
     int player_layer_idx = 0;
 
+    // Tile layers baked by insert_to_scene(), one per (layer, tileset) pair
+    std::vector<TileLayer> tile_layers;
+
     static Ref<Tilemap> load(const char* filename);
 
     void insert_to_scene();
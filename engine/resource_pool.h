@@ -1,12 +1,18 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <cassert>
 
 #include "core/xxhash.h"
 #include "core/log.h"
 #include "core/virtual_alloc.h"
+#include "core/alloc_tracker.h"
 
 #include "reflection.h"
 
@@ -109,6 +115,63 @@ struct std::hash<Ref<T>>
     }
 };
 
+// Compact 32-bit handle made of a slot index and the slot's generation, resolved through the pool it came from.
+// Half the size of a Ref, doesn't depend on the address space layout, and can be serialized.
+// Pools retire a slot once its generation would go past max_generation, so a stale handle never becomes valid again.
+// Only use it in containers whose items all come from one pool (not for refs gathered from descendant pools).
+template <class T>
+struct Handle {
+    static constexpr uint32_t index_bits = 20;
+    static constexpr uint32_t generation_bits = 32 - index_bits;
+    static constexpr uint32_t index_mask = (1u << index_bits) - 1;
+    static constexpr uint32_t max_generation = (1u << generation_bits) - 1;
+
+    uint32_t value;
+
+    Handle() : value(0) {}
+    explicit Handle(uint32_t value) : value(value) {}
+    Handle(uint32_t index, uint16_t gen) {
+        assert(index <= index_mask);
+        // Generations start at 1, so a null handle (0) never matches a live slot
+        assert(gen >= 1 && gen <= max_generation);
+        value = (uint32_t)gen << index_bits | index;
+    }
+
+    explicit operator bool() const {
+        return value != 0;
+    }
+
+    inline uint32_t index() const { return value & index_mask; }
+    inline uint16_t generation() const { return (uint16_t)(value >> index_bits); }
+
+    inline bool operator==(Handle other) const { return value == other.value; }
+    inline bool operator!=(Handle other) const { return value != other.value; }
+};
+
+template <class T>
+struct std::hash<Handle<T>>
+{
+    std::size_t operator()(const Handle<T>& handle) const {
+        return std::hash<uint32_t>()(handle.value);
+    }
+};
+
+struct ResourcePoolStats {
+    uint32_t count = 0;             // Live items
+    uint32_t max_count = 0;         // Slots in use or in the free list
+    uint32_t free_count = 0;        // Free list length
+    uint32_t retired_count = 0;     // Slots that used up their generations and are never handed out again
+    uint32_t reserved_bytes = 0;
+    uint32_t committed_bytes = 0;
+    uint32_t resident_bytes = 0;    // Committed bytes minus the ones trim() gave back
+    std::vector<std::pair<ResourceLabel, uint32_t>> label_counts; // Live items of each label
+
+    // Share of the used slot range that is holes, which foreach (without dense index) and memory pay for
+    float fragmentation() const {
+        return max_count == 0? 0.0f : (float)(free_count + retired_count) / (float)max_count;
+    }
+};
+
 template <class T>
 class StableResourcePool {
 public:
@@ -149,29 +212,274 @@ public:
 private:
     // mknejp::vmcontainer::pinned_vector<Node> nodes;
     Node* nodes = nullptr;
-    uint32_t count = 0;
-    uint32_t max_count = 0;
+    std::atomic<uint32_t> count = 0;
+    std::atomic<uint32_t> max_count = 0;  // High-water mark of used slots, trim() doesn't lower it
     uint32_t reserved_bytes = 0;
     uint32_t committed_bytes = 0;
 
+    // Slots from max_count - trimmed_generations.size() up to max_count got trimmed: they aren't in the free list
+    // and their memory was reset, but it stays readable so stale refs into them just fail validation.
+    // Their generations are kept here (lowest slot last) and restored when growing takes them again.
+    std::vector<uint16_t> trimmed_generations;
+    uint32_t reset_bytes = 0;  // Trimmed bytes at the end of the committed memory
+
+    // A slot whose generation goes past this is retired: it stays out of the free list for good, so neither
+    // refs nor handles to it can ever match a new item (handles only have room for this many generations).
+    static constexpr uint16_t max_generation = Handle<T>::max_generation;
+    uint32_t retired_count = 0;
+
+    inline bool is_retired(const Metadata& meta) const {
+        return !meta.occupied && meta.generation > max_generation;
+    }
+
     ResourceLabel cur_resource_label;
 
-    uint32_t free_list_front = 0xFFFFFFFF;
-    uint32_t free_list_back = 0xFFFFFFFF;
+    // Slots of live items for each label, so releasing a label only touches its own items
+    std::unordered_map<ResourceLabel, std::vector<uint32_t>> label_slots;
+    std::vector<uint32_t>* cur_label_slots = nullptr;
+    std::vector<uint32_t> label_positions; // Slot index -> position in its label's slot list
+
+    inline void label_insert(uint32_t index, std::vector<uint32_t>& slots) {
+        if (index >= label_positions.size()) {
+            label_positions.resize(index + 1);
+        }
+        label_positions[index] = slots.size();
+        slots.push_back(index);
+    }
+
+    inline void label_remove(uint32_t index, ResourceLabel label) {
+        auto it = label_slots.find(label);
+        assert(it != label_slots.end());
+        auto& slots = it->second;
+        uint32_t pos = label_positions[index];
+        uint32_t last = slots.back();
+        slots[pos] = last;
+        label_positions[last] = pos;
+        slots.pop_back();
+    }
+
+    // Free slots are reused LIFO, so recently freed (still cached) slots get taken first.
+    // Holds (tag << 32) | front index, the tag is bumped on every change so concurrent pops can't suffer from ABA.
+    std::atomic<uint64_t> free_list_head = 0xFFFFFFFF;
+
+    inline uint32_t free_list_front() const {
+        return (uint32_t)free_list_head.load(std::memory_order_relaxed);
+    }
+
+    inline void set_free_list_front(uint32_t index) {
+        uint64_t head = free_list_head.load(std::memory_order_relaxed);
+        free_list_head.store(((head >> 32) + 1) << 32 | index, std::memory_order_relaxed);
+    }
+
+    // Takes the front slot of the free list, or returns 0xFFFFFFFF if it's empty.
+    uint32_t pop_free_slot() {
+        if (!use_concurrent) {
+            uint32_t index = free_list_front();
+            if (index != 0xFFFFFFFF) {
+                set_free_list_front(nodes[index].meta.index_or_resource_label);
+            }
+            return index;
+        }
+        uint64_t head = free_list_head.load(std::memory_order_acquire);
+        while ((uint32_t)head != 0xFFFFFFFF) {
+            // The next index may be garbage if another thread took this slot meanwhile, but then the tag changed
+            uint32_t next = nodes[(uint32_t)head].meta.index_or_resource_label;
+            uint64_t new_head = ((head >> 32) + 1) << 32 | next;
+            if (free_list_head.compare_exchange_weak(head, new_head, std::memory_order_acquire)) {
+                return (uint32_t)head;
+            }
+        }
+        return 0xFFFFFFFF;
+    }
+
+    // Pushes an already linked chain of free slots (first -> ... -> last) to the front of the free list.
+    void push_free_slots(uint32_t first, uint32_t last) {
+        if (!use_concurrent) {
+            nodes[last].meta.change_index(free_list_front());
+            set_free_list_front(first);
+            return;
+        }
+        uint64_t head = free_list_head.load(std::memory_order_relaxed);
+        do {
+            nodes[last].meta.change_index((uint32_t)head);
+        } while (!free_list_head.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | first, std::memory_order_release));
+    }
+
+    // Opt-in concurrent mode: any thread can create and release items. Only the owner thread touches the
+    // label lists and the dense index, other threads queue their new slots and releases until sync().
+    bool use_concurrent = false;
+    std::thread::id owner_thread;
+    std::mutex growth_mutex;
+    std::mutex pending_mutex;
+    std::vector<uint32_t> pending_inserts;
+    std::atomic<bool> has_pending_inserts = false;
+
+    // Releases deferred until sync() (from release_deferred(), or from other threads in concurrent mode)
+    std::vector<Ref<T>> pending_releases;
+    std::vector<Ref<T>> releasing; // Kept around so sync() doesn't allocate every frame
+
+    inline bool on_owner_thread() const {
+        return !use_concurrent || std::this_thread::get_id() == owner_thread;
+    }
+
+    // Registers a newly occupied slot in the label lists and the dense index.
+    inline void track_slot(uint32_t index, ResourceLabel label) {
+        if (!use_concurrent) {
+            dense_insert(index);
+            label_insert(index, *cur_label_slots);
+        }
+        else if (on_owner_thread()) {
+            dense_insert(index);
+            label_insert(index, label_slots[label]);
+        }
+        else {
+            std::lock_guard lock(pending_mutex);
+            pending_inserts.push_back(index);
+            has_pending_inserts.store(true, std::memory_order_release);
+        }
+    }
+
+    // Tracks the slots created by other threads, so they can be released on the owner thread.
+    void flush_pending_inserts() {
+        if (!use_concurrent || !has_pending_inserts.load(std::memory_order_acquire)) return;
+        std::lock_guard lock(pending_mutex);
+        for (uint32_t index : pending_inserts) {
+            dense_insert(index);
+            label_insert(index, label_slots[nodes[index].meta.index_or_resource_label]);
+        }
+        pending_inserts.clear();
+        has_pending_inserts.store(false, std::memory_order_relaxed);
+    }
+
+    // Optional packed array of live slot indices, so iteration only touches live items.
+    bool use_dense_index = false;
+    std::vector<uint32_t> dense_indices;
+    std::vector<uint32_t> dense_positions; // Slot index -> position in dense_indices
+    // Position foreach() is visiting (0 outside of it). Releasing an already visited item would swap
+    // an unvisited one behind it, so only the current item or later ones can be released meanwhile.
+    uint32_t dense_visit_pos = 0;
+
+    inline void dense_insert(uint32_t index) {
+        if (!use_dense_index) return;
+        if (index >= dense_positions.size()) {
+            dense_positions.resize(index + 1);
+        }
+        dense_positions[index] = dense_indices.size();
+        dense_indices.push_back(index);
+    }
+
+    inline void dense_remove(uint32_t index) {
+        if (!use_dense_index) return;
+        // Swap-remove: move the last live slot into the removed position
+        uint32_t pos = dense_positions[index];
+        assert(pos >= dense_visit_pos && "Use release_deferred() to release other items inside foreach()");
+        uint32_t last = dense_indices.back();
+        dense_indices[pos] = last;
+        dense_positions[last] = pos;
+        dense_indices.pop_back();
+    }
 
     uint32_t round_bytes_to_page_alignment(uint32_t bytes) {
         return ((bytes - 1) / virtual_page_size + 1) * virtual_page_size;
     }
 
+    // Memory is committed at least this much at a time, so growing one item at a time doesn't commit page by page
+    static constexpr uint32_t min_commit_bytes = 64 * 1024;
+    // With huge pages, commit (and trim) whole 2MB pages so the OS can actually back them with one
+    static constexpr uint32_t huge_page_bytes = 2 * 1024 * 1024;
+
+    bool use_huge_pages = false;
+
+    uint32_t commit_granularity() const {
+        return use_huge_pages? huge_page_bytes : min_commit_bytes;
+    }
+
     void expand_memory(uint32_t new_bytes) {
         if (new_bytes > reserved_bytes) {
             log_error("Inserted too many items in ResourcePool<{}>!", type_name<T>());
             log_error("reserved_bytes={}, count={}", reserved_bytes, count);
         }
         else if (new_bytes > committed_bytes) {
-            virtual_commit((unsigned char*)nodes + committed_bytes, new_bytes - committed_bytes);
+            uint32_t commit_bytes = round_bytes_to_page_alignment(std::max(new_bytes, committed_bytes + commit_granularity()));
+            commit_bytes = std::min(commit_bytes, reserved_bytes);
+            virtual_commit((unsigned char*)nodes + committed_bytes, commit_bytes - committed_bytes);
+            alloc_track_committed_range(nodes, committed_bytes, commit_bytes);
+            committed_bytes = commit_bytes;
         }
-        committed_bytes = new_bytes;
+    }
+
+    // Takes n slots (reusing free ones first) and calls construct(i, item) to construct each item in place.
+    template <class Construct>
+    void new_nodes(uint32_t n, Ref<T>* out_refs, Construct&& construct) {
+        ResourceLabel label = cur_resource_label;
+        uint32_t i = 0;
+        for (; i < n; i++) {
+            uint32_t index = pop_free_slot();
+            if (index == 0xFFFFFFFF) break;
+            Node& node = nodes[index];
+            node.meta.set_occupied(label);
+            construct(i, node.item);
+            out_refs[i] = Ref<T>(&node.item, node.meta.generation);
+            track_slot(index, label);
+        }
+
+        if (i < n) {
+            // Free list is empty, so claim the remaining slots at the end (committing memory once)
+            uint32_t remaining = n - i;
+            uint32_t first;
+            {
+                std::unique_lock lock(growth_mutex, std::defer_lock);
+                if (use_concurrent) lock.lock();
+                first = max_count - trimmed_generations.size();
+                assert(use_concurrent || first == count + retired_count + i);
+                uint32_t end = first + remaining;
+
+                uint32_t touched_bytes = std::min(round_bytes_to_page_alignment(sizeof(Node)*end), committed_bytes);
+                reset_bytes = std::min(reset_bytes, committed_bytes - touched_bytes);
+                expand_memory(round_bytes_to_page_alignment(sizeof(Node)*end));
+                if (use_dense_index && on_owner_thread()) {
+                    dense_indices.reserve(dense_indices.size() + remaining);
+                    dense_positions.resize(std::max((uint32_t)dense_positions.size(), end));
+                }
+
+                // Trimmed slots come back with the generation they had, so old refs to them stay invalid
+                for (uint32_t index = first; index < end; index++) {
+                    auto& meta = nodes[index].meta;
+                    new (&meta) Metadata();
+                    if (!trimmed_generations.empty()) {
+                        meta.generation = trimmed_generations.back();
+                        trimmed_generations.pop_back();
+                    }
+                }
+                max_count = std::max(max_count.load(), end);
+            }
+            for (uint32_t index = first; i < n; i++, index++) {
+                auto& node = nodes[index];
+                node.meta.set_occupied(label);
+                construct(i, node.item);
+                out_refs[i] = Ref<T>(&node.item, node.meta.generation);
+                track_slot(index, label);
+            }
+        }
+        count += n;
+    }
+
+    // Destroys the item in an occupied slot and pushes the slot to the front of the free list.
+    void free_slot(uint32_t index) {
+        Node& node = nodes[index];
+        label_remove(index, node.meta.index_or_resource_label);
+        node.item.~T();
+        node.meta.set_free();
+        dense_remove(index);
+
+        if (is_retired(node.meta)) {
+            retired_count++;
+        }
+        else {
+            push_free_slots(index, index);
+        }
+
+        count--;
     }
 
 public:
@@ -179,14 +487,42 @@ public:
     {
         reserved_bytes = round_bytes_to_page_alignment(sizeof(Node) * max_elements);
         nodes = static_cast<Node*>(virtual_alloc(reserved_bytes));
+        set_resource_label(make_res_label("all"));
     }
     ~StableResourcePool() {
+        if (committed_bytes > 0) {
+            alloc_track_decommit(committed_bytes);
+            alloc_track_committed_range(nodes, committed_bytes, 0);
+        }
         virtual_free(nodes, reserved_bytes);
     }
 
     uint32_t size() const { return count; }
 
+    uint32_t get_committed_bytes() const { return committed_bytes; }
+    // Committed memory that wasn't given back by trim() (it stays committed, but the OS can drop its pages)
+    uint32_t get_resident_bytes() const { return committed_bytes - reset_bytes; }
+
+    ResourcePoolStats get_stats() const {
+        ResourcePoolStats stats;
+        stats.count = count;
+        stats.max_count = max_count - trimmed_generations.size();
+        // Every slot below that which isn't live or retired is in the free list
+        stats.retired_count = retired_count;
+        stats.free_count = stats.max_count - count - retired_count;
+        stats.reserved_bytes = reserved_bytes;
+        stats.committed_bytes = committed_bytes;
+        stats.resident_bytes = get_resident_bytes();
+        for (auto& [label, slots] : label_slots) {
+            if (!slots.empty()) {
+                stats.label_counts.emplace_back(label, (uint32_t)slots.size());
+            }
+        }
+        return stats;
+    }
+
     void clear() {
+        assert(on_owner_thread());
         for (int i = 0; i < max_count; i++) {
             auto& node = nodes[i];
             if (node.meta.occupied) {
@@ -196,12 +532,138 @@ public:
 
         count = 0;
         max_count = 0;
+        trimmed_generations.clear();
+        retired_count = 0;
 
-        virtual_decommit(nodes, committed_bytes);
+        if (committed_bytes > 0) {
+            virtual_decommit(nodes, committed_bytes);
+            alloc_track_committed_range(nodes, committed_bytes, 0);
+        }
         committed_bytes = 0;
+        reset_bytes = 0;
 
-        cur_resource_label = make_res_label("all");
-        free_list_front = free_list_back = 0xFFFFFFFF;
+        set_free_list_front(0xFFFFFFFF);
+
+        dense_indices.clear();
+        dense_positions.clear();
+
+        label_slots.clear();
+        label_positions.clear();
+        set_resource_label(make_res_label("all"));
+    }
+
+    // Keep a packed index of live slots from now on. foreach() and foreach_ref() then cost O(live items)
+    // instead of scanning every slot ever used, but the iteration order is no longer the slot order.
+    void enable_dense_index() {
+        if (use_dense_index) return;
+        use_dense_index = true;
+        dense_indices.clear();
+        dense_positions.resize(max_count);
+        for (uint32_t i = 0; i < max_count; i++) {
+            if (nodes[i].meta.occupied) {
+                dense_insert(i);
+            }
+        }
+    }
+
+    // Ask the OS to back this pool with huge pages (Linux only), so iterating a big hot pool takes fewer TLB misses.
+    // Memory then gets committed and trimmed in 2MB steps.
+    void enable_huge_pages() {
+        if (use_huge_pages) return;
+        use_huge_pages = true;
+        virtual_advise_huge_pages(nodes, reserved_bytes);
+    }
+
+    // Gives the memory of the free slots at the end of the pool back to the OS (in commit granularity steps),
+    // so the memory of a big unloaded scene doesn't stay resident. Only slots past the last live item can go.
+    // Returns the number of bytes given back. The memory stays committed and keeps its slots' generations,
+    // so refs to trimmed slots are still safe to check and never become valid again.
+    // Concurrent pools are never trimmed, since other threads can pop the free list while it gets unlinked.
+    uint32_t trim() {
+        assert(on_owner_thread());
+        if (use_concurrent) return 0;
+        uint32_t old_top = max_count - trimmed_generations.size();
+        uint32_t top = old_top;
+        // Retired slots stay, regrowing would hand them out again
+        while (top > 0 && !nodes[top - 1].meta.occupied && !is_retired(nodes[top - 1].meta)) {
+            top--;
+        }
+        uint32_t keep_bytes = ((sizeof(Node) * top + commit_granularity() - 1) / commit_granularity()) * commit_granularity();
+        keep_bytes = round_bytes_to_page_alignment(keep_bytes);
+        if (keep_bytes >= committed_bytes - reset_bytes) return 0;
+
+        // Slots whose metadata still lies in the kept memory stay in the free list
+        uint32_t new_top = keep_bytes == 0? 0 : (keep_bytes - sizeof(Metadata)) / sizeof(Node) + 1;
+        new_top = std::clamp(new_top, top, old_top);
+
+        // Unlink the trimmed slots from the free list, and remember their generations
+        uint32_t front = free_list_front();
+        uint32_t* link = &front;
+        while (*link != 0xFFFFFFFF) {
+            uint32_t index = *link;
+            if (index >= new_top) {
+                *link = nodes[index].meta.index_or_resource_label;
+            }
+            else {
+                link = &nodes[index].meta.index_or_resource_label;
+            }
+        }
+        set_free_list_front(front);
+        for (uint32_t index = old_top; index > new_top; index--) {
+            trimmed_generations.push_back(nodes[index - 1].meta.generation);
+        }
+
+        uint32_t trimmed_bytes = committed_bytes - reset_bytes - keep_bytes;
+        virtual_reset((unsigned char*)nodes + keep_bytes, trimmed_bytes);
+        reset_bytes += trimmed_bytes;
+        return trimmed_bytes;
+    }
+
+    // Allow creating and releasing items from any thread. Releases from other threads are deferred until sync(),
+    // which has to be called on the thread calling this (the owner). Items created by other threads are valid
+    // through their refs right away, but foreach() and release(label) only see them once the owner thread
+    // tracks them, in the next sync() (or in the next release() on the owner thread).
+    // Label changes, release(label) and clear() still have to happen on the owner thread, and trim() does nothing.
+    void enable_concurrent() {
+        if (use_concurrent) return;
+        // Scanning slots could otherwise run into items still being constructed
+        enable_dense_index();
+        owner_thread = std::this_thread::get_id();
+        use_concurrent = true;
+    }
+
+    // Queues the item to be released at the next sync(), so it's safe to call while iterating the pool.
+    // The item stays valid until then, and releasing it more than once (or after it got released) is fine.
+    void release_deferred(Ref<T> ref) {
+        std::unique_lock lock(pending_mutex, std::defer_lock);
+        if (use_concurrent) lock.lock();
+        pending_releases.push_back(ref);
+    }
+
+    // Sync point, called once a frame: releases the deferred items in slot order, and in concurrent mode
+    // tracks the items other threads created first.
+    void sync() {
+        assert(on_owner_thread());
+        flush_pending_inserts();
+
+        // Destructors may defer more releases, so keep going until the queue is empty
+        while (true) {
+            {
+                std::unique_lock lock(pending_mutex, std::defer_lock);
+                if (use_concurrent) lock.lock();
+                if (pending_releases.empty()) break;
+                std::swap(releasing, pending_releases);
+            }
+            std::sort(releasing.begin(), releasing.end(), [](Ref<T> a, Ref<T> b) {
+                return a.get_unsafe() < b.get_unsafe();
+            });
+            releasing.erase(std::unique(releasing.begin(), releasing.end()), releasing.end());
+            releasing.erase(std::remove_if(releasing.begin(), releasing.end(), [this](Ref<T> ref) {
+                return !is_valid(ref);
+            }), releasing.end());
+            release_items(releasing.data(), releasing.size());
+            releasing.clear();
+        }
     }
 
     ResourceLabel get_resource_label() {
@@ -210,39 +672,35 @@ public:
 
     void set_resource_label(ResourceLabel label) {
         this->cur_resource_label = label;
+        // References to unordered_map elements stay valid when other labels get inserted
+        this->cur_label_slots = &label_slots[label];
     }
 
     template <class ...Args>
     Ref<T> new_item(Args&&... args) {
         Ref<T> ptr;
-        if (free_list_front == 0xFFFFFFFF) {
-            // If free list is empty, create new free list node
-            assert(max_count == count);
-            uint32_t new_bytes = round_bytes_to_page_alignment(sizeof(Node)*(max_count + 1));
-            expand_memory(new_bytes);
-            auto& node = nodes[max_count];
-            new (&node.meta) Metadata();
-            node.meta.set_occupied(cur_resource_label);
-            new (&node.item) T(args...);
-            ptr = Ref<T>(&node.item, node.meta.generation);
-            max_count++;
-        }
-        else {
-            // Take the front node of free list
-            Node& node = nodes[free_list_front];
-            // Remove node from free list
-            free_list_front = node.meta.index_or_resource_label;
-            if (free_list_front == 0xFFFFFFFF) {
-                free_list_back = 0xFFFFFFFF;
-            }
-            node.meta.set_occupied(cur_resource_label);
-            new (&node.item) T(args...);
-            ptr = Ref<T>(&node.item, node.meta.generation);
-        }
-        count++;
+        new_nodes(1, &ptr, [&](uint32_t, T& item) {
+            new (&item) T(args...);
+        });
         return ptr;
     }
 
+    // Allocates n items constructed from the same arguments.
+    template <class ...Args>
+    void new_items(uint32_t n, Ref<T>* out_refs, Args&&... args) {
+        new_nodes(n, out_refs, [&](uint32_t, T& item) {
+            new (&item) T(args...);
+        });
+    }
+
+    // Allocates n items, constructing the i-th item from make_arg(i) (ex. a list of Options).
+    template <class Fun>
+    void new_items_from(uint32_t n, Ref<T>* out_refs, Fun&& make_arg) {
+        new_nodes(n, out_refs, [&](uint32_t i, T& item) {
+            new (&item) T(make_arg(i));
+        });
+    }
+
     Ref<T> insert(const T& item) {
         auto ptr = new_item();
         *ptr.get_unsafe() = item;
@@ -255,20 +713,6 @@ public:
         return ptr;
     }
 
-    // TODO: more optimized implementation?
-    /*
-    void insert_n(std::span<Id<T>> ids, const T& item) {
-        items.reserve(items.size() + ids.size());
-        resource_labels.reserve(items.size() + ids.size());
-        dense_to_sparse_map.reserve(dense_to_sparse_map.size() + ids.size());
-        fragmented = true;
-
-        for (int i = 0; i < ids.size(); i++) {
-            ids[i] = insert(item);
-        }
-    }
-     */
-
     // WARNING: Extremely evil but necessary pointer manipulation to access metadata header
     static inline Node* get_node_from_item(const T* item) {
         return reinterpret_cast<Node*>(reinterpret_cast<std::uintptr_t>(item) - offsetof(Node, item));
@@ -288,7 +732,46 @@ public:
         return (uint32_t)index;
     }
 
+    Handle<T> get_handle(Ref<T> ref) {
+        return Handle<T>(get_index(ref), ref.generation());
+    }
+
+    // Returns the Ref of a live handle, or a null Ref if the item was released.
+    Ref<T> get_ref(Handle<T> handle) {
+        if (!is_valid(handle)) return Ref<T>();
+        Node& node = nodes[handle.index()];
+        return Ref<T>(&node.item, node.meta.generation);
+    }
+
+    bool is_valid(Handle<T> handle) const {
+        uint32_t index = handle.index();
+        if (!handle || index >= max_count) return false;
+        const Metadata& meta = nodes[index].meta;
+        return meta.occupied && meta.generation == handle.generation();
+    }
+
+    T* get(Handle<T> handle) {
+        assert(is_valid(handle));
+        return &nodes[handle.index()].item;
+    }
+
+    T* try_get(Handle<T> handle) {
+        if (!is_valid(handle)) return nullptr;
+        return &nodes[handle.index()].item;
+    }
+
+    bool release(Handle<T> handle) {
+        assert(is_valid(handle));
+        return release(get_ref(handle));
+    }
+
     bool release(Ref<T> ref) {
+        if (!on_owner_thread()) {
+            release_deferred(ref);
+            return true;
+        }
+        flush_pending_inserts();
+
         T* item = ref.get_unsafe();
         Node* node = get_node_from_item(item);
 
@@ -299,45 +782,65 @@ public:
         assert(node->meta.generation == gen);
         assert(node->meta.tid == type_id<T>());
 
-        node->item.~T();
-        node->meta.set_free();
+        free_slot(index);
+        return true;
+    }
 
-        // If free list is empty, create free list with one element
-        if (free_list_front == 0xFFFFFFFF) {
-            free_list_back = free_list_front = index;
+    // Releases n items, linking their slots into the front of the free list in one pass.
+    void release_items(const Ref<T>* refs, uint32_t n) {
+        if (n == 0) return;
+        if (!on_owner_thread()) {
+            std::lock_guard lock(pending_mutex);
+            pending_releases.insert(pending_releases.end(), refs, refs + n);
+            return;
         }
-        else {
-            nodes[free_list_back].meta.change_index(index);
-            free_list_back = index;
+        flush_pending_inserts();
+
+        uint32_t first = 0xFFFFFFFF, prev = 0xFFFFFFFF;
+        for (uint32_t i = 0; i < n; i++) {
+            Node* node = get_node_from_item(refs[i].get_unsafe());
+            uint32_t index = node - nodes;
+            assert(index >= 0 && index < max_count);
+            assert(node->meta.generation == refs[i].generation());
+            assert(node->meta.tid == type_id<T>());
+
+            label_remove(index, node->meta.index_or_resource_label);
+            node->item.~T();
+            node->meta.set_free();
+            dense_remove(index);
+
+            if (is_retired(node->meta)) {
+                retired_count++;
+                continue;
+            }
+            if (prev == 0xFFFFFFFF) {
+                first = index;
+            }
+            else {
+                nodes[prev].meta.change_index(index);
+            }
+            prev = index;
+        }
+        if (first != 0xFFFFFFFF) {
+            push_free_slots(first, prev);
         }
-        nodes[free_list_back].meta.change_index(0xFFFFFFFF);
-
-        count--;
 
-        return true;
+        count -= n;
     }
 
     int release(ResourceLabel label) {
-        int released_count = 0;
-        for (int index = 0; index < max_count; index++) {
-            auto& node = nodes[index];
-            if (node.meta.occupied && node.meta.index_or_resource_label == label) {
-                node.item.~T();
-                node.meta.set_free();
-
-                if (free_list_front == 0xFFFFFFFF) {
-                    free_list_back = free_list_front = index;
-                }
-                else {
-                    nodes[free_list_back].meta.change_index(index);
-                    free_list_back = index;
-                }
-                nodes[free_list_back].meta.change_index(0xFFFFFFFF);
+        assert(on_owner_thread());
+        flush_pending_inserts();
+        auto it = label_slots.find(label);
+        if (it == label_slots.end()) return 0;
 
-                released_count++;
-            }
+        // Pop from the back, so destructors releasing other items of this label keep the list consistent
+        auto& slots = it->second;
+        int released_count = 0;
+        while (!slots.empty()) {
+            free_slot(slots.back());
+            released_count++;
         }
-        count -= released_count;
         return released_count;
     }
 
@@ -402,36 +905,52 @@ public:
         return item;
     }
 
+    // Calls fun(node) for every live node. fun may release the current item, but other items have to go through
+    // release_deferred() (with the dense index, releasing an already visited item makes another one get skipped).
     template <class Fun>
-    void foreach(Fun&& fun) {
-        for (int i = 0; i < max_count; i++) {
-            auto& node = nodes[i];
-            if (node.meta.occupied) {
-                fun(node.item);
+    void foreach_node(Fun&& fun) {
+        if (use_dense_index) {
+            uint32_t outer_visit_pos = dense_visit_pos;
+            for (uint32_t i = 0; i < dense_indices.size(); ) {
+                uint32_t index = dense_indices[i];
+                dense_visit_pos = i;
+                fun(nodes[index]);
+                // If fun released this item, another one got swapped into its position
+                if (i < dense_indices.size() && dense_indices[i] == index) i++;
+            }
+            dense_visit_pos = outer_visit_pos;
+        }
+        else {
+            for (int i = 0; i < max_count; i++) {
+                auto& node = nodes[i];
+                if (node.meta.occupied) {
+                    fun(node);
+                }
             }
         }
     }
 
+    template <class Fun>
+    void foreach(Fun&& fun) {
+        foreach_node([&](Node& node) {
+            fun(node.item);
+        });
+    }
+
     template <class Fun>
     void foreach_ref(Fun&& fun) {
-        for (int i = 0; i < max_count; i++) {
-            auto& node = nodes[i];
-            if (node.meta.occupied) {
-                Ref<T> ref(&node.item, node.meta.generation);
-                fun(ref, node.item);
-            }
-        }
+        foreach_node([&](Node& node) {
+            Ref<T> ref(&node.item, node.meta.generation);
+            fun(ref, node.item);
+        });
     }
 
     template <class TBase, class Fun>
     void foreach_ref(Fun&& fun) {
-        for (int i = 0; i < max_count; i++) {
-            auto& node = nodes[i];
-            if (node.meta.occupied) {
-                Ref<TBase> ref(static_cast<TBase*>(&node.item), node.meta.generation);
-                fun(ref, static_cast<TBase&>(node.item));
-            }
-        }
+        foreach_node([&](Node& node) {
+            Ref<TBase> ref(static_cast<TBase*>(&node.item), node.meta.generation);
+            fun(ref, static_cast<TBase&>(node.item));
+        });
     }
 };
 
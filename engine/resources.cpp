@@ -8,8 +8,27 @@
 #include "engine.h"
 #include "squirrel/scriptable_impl.h"
 
+#include <Tracy.hpp>
+
 Resources::Resources() {
     push_label(make_res_label("all"));
+
+    // Node pools get iterated every frame, and churn a lot
+    pool_Animation.enable_dense_index();
+    pool_Animation_scriptable.enable_dense_index();
+    pool_Collider.enable_dense_index();
+    pool_Collider_scriptable.enable_dense_index();
+    pool_KinematicBody.enable_dense_index();
+    pool_KinematicBody_scriptable.enable_dense_index();
+    pool_Node.enable_dense_index();
+    pool_Node_scriptable.enable_dense_index();
+    pool_Sprite.enable_dense_index();
+    pool_Sprite_scriptable.enable_dense_index();
+    pool_Text.enable_dense_index();
+    pool_Text_scriptable.enable_dense_index();
+
+    // Pools that worker threads can create items in (ex. while loading assets)
+    pool_Sprite.enable_concurrent();
 }
 
 Resources::~Resources() {
@@ -50,6 +69,129 @@ void Resources::release_with_label(ResourceLabel label) {
     pool_Tileset.release(label);
 }
 
+void Resources::trim_pools() {
+    ZoneScoped
+    pool_Animation.trim();
+    pool_Animation_scriptable.trim();
+    pool_AudioInstance.trim();
+    pool_AudioSource.trim();
+    pool_Collider.trim();
+    pool_Collider_scriptable.trim();
+    pool_Font.trim();
+    pool_Image.trim();
+    pool_KinematicBody.trim();
+    pool_KinematicBody_scriptable.trim();
+    pool_Node.trim();
+    pool_Node_scriptable.trim();
+    pool_ScriptModule.trim();
+    pool_Sprite.trim();
+    pool_Sprite_scriptable.trim();
+    pool_Text.trim();
+    pool_Text_scriptable.trim();
+    pool_Texture.trim();
+    pool_Tilemap.trim();
+    pool_Tileset.trim();
+}
+
+void Resources::sync_pools() {
+    pool_Animation.sync();
+    pool_Animation_scriptable.sync();
+    pool_AudioInstance.sync();
+    pool_AudioSource.sync();
+    pool_Collider.sync();
+    pool_Collider_scriptable.sync();
+    pool_Font.sync();
+    pool_Image.sync();
+    pool_KinematicBody.sync();
+    pool_KinematicBody_scriptable.sync();
+    pool_Node.sync();
+    pool_Node_scriptable.sync();
+    pool_ScriptModule.sync();
+    pool_Sprite.sync();
+    pool_Sprite_scriptable.sync();
+    pool_Text.sync();
+    pool_Text_scriptable.sync();
+    pool_Texture.sync();
+    pool_Tilemap.sync();
+    pool_Tileset.sync();
+}
+
+std::vector<Resources::PoolStats> Resources::get_pool_stats() const {
+    std::vector<PoolStats> stats;
+    stats.push_back({"Animation", pool_Animation.get_stats()});
+    stats.push_back({"Scriptable<Animation>", pool_Animation_scriptable.get_stats()});
+    stats.push_back({"AudioInstance", pool_AudioInstance.get_stats()});
+    stats.push_back({"AudioSource", pool_AudioSource.get_stats()});
+    stats.push_back({"Collider", pool_Collider.get_stats()});
+    stats.push_back({"Scriptable<Collider>", pool_Collider_scriptable.get_stats()});
+    stats.push_back({"Font", pool_Font.get_stats()});
+    stats.push_back({"Image", pool_Image.get_stats()});
+    stats.push_back({"KinematicBody", pool_KinematicBody.get_stats()});
+    stats.push_back({"Scriptable<KinematicBody>", pool_KinematicBody_scriptable.get_stats()});
+    stats.push_back({"Node", pool_Node.get_stats()});
+    stats.push_back({"Scriptable<Node>", pool_Node_scriptable.get_stats()});
+    stats.push_back({"ScriptModule", pool_ScriptModule.get_stats()});
+    stats.push_back({"Sprite", pool_Sprite.get_stats()});
+    stats.push_back({"Scriptable<Sprite>", pool_Sprite_scriptable.get_stats()});
+    stats.push_back({"Text", pool_Text.get_stats()});
+    stats.push_back({"Scriptable<Text>", pool_Text_scriptable.get_stats()});
+    stats.push_back({"Texture", pool_Texture.get_stats()});
+    stats.push_back({"Tilemap", pool_Tilemap.get_stats()});
+    stats.push_back({"Tileset", pool_Tileset.get_stats()});
+    return stats;
+}
+
+void Resources::plot_pool_stats() const {
+    TracyPlot("Pool Animation Items", (int64_t)pool_Animation.size());
+    TracyPlot("Pool Animation Committed", (int64_t)pool_Animation.get_committed_bytes());
+    TracyPlot("Pool Animation Resident", (int64_t)pool_Animation.get_resident_bytes());
+    TracyPlot("Pool Scriptable<Animation> Items", (int64_t)pool_Animation_scriptable.size());
+    TracyPlot("Pool AudioInstance Items", (int64_t)pool_AudioInstance.size());
+    TracyPlot("Pool AudioInstance Committed", (int64_t)pool_AudioInstance.get_committed_bytes());
+    TracyPlot("Pool AudioInstance Resident", (int64_t)pool_AudioInstance.get_resident_bytes());
+    TracyPlot("Pool AudioSource Items", (int64_t)pool_AudioSource.size());
+    TracyPlot("Pool AudioSource Committed", (int64_t)pool_AudioSource.get_committed_bytes());
+    TracyPlot("Pool AudioSource Resident", (int64_t)pool_AudioSource.get_resident_bytes());
+    TracyPlot("Pool Collider Items", (int64_t)pool_Collider.size());
+    TracyPlot("Pool Collider Committed", (int64_t)pool_Collider.get_committed_bytes());
+    TracyPlot("Pool Collider Resident", (int64_t)pool_Collider.get_resident_bytes());
+    TracyPlot("Pool Scriptable<Collider> Items", (int64_t)pool_Collider_scriptable.size());
+    TracyPlot("Pool Font Items", (int64_t)pool_Font.size());
+    TracyPlot("Pool Font Committed", (int64_t)pool_Font.get_committed_bytes());
+    TracyPlot("Pool Font Resident", (int64_t)pool_Font.get_resident_bytes());
+    TracyPlot("Pool Image Items", (int64_t)pool_Image.size());
+    TracyPlot("Pool Image Committed", (int64_t)pool_Image.get_committed_bytes());
+    TracyPlot("Pool Image Resident", (int64_t)pool_Image.get_resident_bytes());
+    TracyPlot("Pool KinematicBody Items", (int64_t)pool_KinematicBody.size());
+    TracyPlot("Pool KinematicBody Committed", (int64_t)pool_KinematicBody.get_committed_bytes());
+    TracyPlot("Pool KinematicBody Resident", (int64_t)pool_KinematicBody.get_resident_bytes());
+    TracyPlot("Pool Scriptable<KinematicBody> Items", (int64_t)pool_KinematicBody_scriptable.size());
+    TracyPlot("Pool Node Items", (int64_t)pool_Node.size());
+    TracyPlot("Pool Node Committed", (int64_t)pool_Node.get_committed_bytes());
+    TracyPlot("Pool Node Resident", (int64_t)pool_Node.get_resident_bytes());
+    TracyPlot("Pool Scriptable<Node> Items", (int64_t)pool_Node_scriptable.size());
+    TracyPlot("Pool ScriptModule Items", (int64_t)pool_ScriptModule.size());
+    TracyPlot("Pool ScriptModule Committed", (int64_t)pool_ScriptModule.get_committed_bytes());
+    TracyPlot("Pool ScriptModule Resident", (int64_t)pool_ScriptModule.get_resident_bytes());
+    TracyPlot("Pool Sprite Items", (int64_t)pool_Sprite.size());
+    TracyPlot("Pool Sprite Committed", (int64_t)pool_Sprite.get_committed_bytes());
+    TracyPlot("Pool Sprite Resident", (int64_t)pool_Sprite.get_resident_bytes());
+    TracyPlot("Pool Scriptable<Sprite> Items", (int64_t)pool_Sprite_scriptable.size());
+    TracyPlot("Pool Text Items", (int64_t)pool_Text.size());
+    TracyPlot("Pool Text Committed", (int64_t)pool_Text.get_committed_bytes());
+    TracyPlot("Pool Text Resident", (int64_t)pool_Text.get_resident_bytes());
+    TracyPlot("Pool Scriptable<Text> Items", (int64_t)pool_Text_scriptable.size());
+    TracyPlot("Pool Texture Items", (int64_t)pool_Texture.size());
+    TracyPlot("Pool Texture Committed", (int64_t)pool_Texture.get_committed_bytes());
+    TracyPlot("Pool Texture Resident", (int64_t)pool_Texture.get_resident_bytes());
+    TracyPlot("Pool Tilemap Items", (int64_t)pool_Tilemap.size());
+    TracyPlot("Pool Tilemap Committed", (int64_t)pool_Tilemap.get_committed_bytes());
+    TracyPlot("Pool Tilemap Resident", (int64_t)pool_Tilemap.get_resident_bytes());
+    TracyPlot("Pool Tileset Items", (int64_t)pool_Tileset.size());
+    TracyPlot("Pool Tileset Committed", (int64_t)pool_Tileset.get_committed_bytes());
+    TracyPlot("Pool Tileset Resident", (int64_t)pool_Tileset.get_resident_bytes());
+}
+
 void Resources::set_labels_for_resource_pools(ResourceLabel label) {
     pool_Animation.set_resource_label(label);
     pool_Animation_scriptable.set_resource_label(label);
@@ -115,6 +115,24 @@ public:
 
     void release_with_label(ResourceLabel label);
 
+    // Gives the memory of the free slots at the end of every pool back to the OS (ex. after unloading a scene).
+    void trim_pools();
+
+    // Releases the items queued with release_deferred() (and tracks the items other threads created in concurrent
+    // pools). Called once a frame on the main thread, after the collision update.
+    void sync_pools();
+
+    struct PoolStats {
+        const char* name;
+        ResourcePoolStats stats;
+    };
+
+    // Stats of every resource pool (Scriptable pools included).
+    std::vector<PoolStats> get_pool_stats() const;
+
+    // Emits live item counts and committed and resident memory of every pool as Tracy plots, called once a frame.
+    void plot_pool_stats() const;
+
     template <class T>
     StableResourcePool<T>& get_pool();
 
@@ -162,6 +180,11 @@ public:
     template <class T, class ...Args>
     Ref<T> new_item(Args&&... args) { return get_pool<T>().new_item(std::forward<Args>(args)...); }
 
+    template <class T, class ...Args>
+    void new_items(uint32_t n, Ref<T>* out_refs, Args&&... args) {
+        get_pool<T>().new_items(n, out_refs, std::forward<Args>(args)...);
+    }
+
     template <class T, class Fun>
     void foreach(Fun&& fun) {
         if constexpr (std::is_void_v<T>) {
@@ -10,6 +10,7 @@
 #include "core/log.h"
 #include "render/sprite.h"
 #include "render/tilemap.h"
+#include "collision/collision_manager.h"
 #include "squirrel/utils.h"
 #include "squirrel/vm.h"
 #include "resource_pool.h"
@@ -111,6 +112,11 @@ void Scene::release() {
     // sq_release(vm, &cls.obj);
 
     res->release_with_label(res_label);
+    res->trim_pools();
+    if (tilemap_ref) {
+        // The collision grids covered this scene's map
+        engine->get_collision_manager()->clear_bounds();
+    }
     res->pop_label();
 }
 
@@ -34,4 +34,31 @@ void main() {
 }
 #pragma sokol @end
 
-#pragma sokol @program sprite vs fs
\ No newline at end of file
+#pragma sokol @program sprite vs fs
+
+#pragma sokol @vs vs_instanced
+// Quad corner, from (0, 0) to (1, 1)
+layout (location = 0) in vec2 a_corner;
+// Per sprite: the x and y axes of its transform (scaled by the sprite size), the position of its
+// top-left corner, its uv rect (u0, v0, u1, v1) and its color
+layout (location = 1) in vec4 i_axes;
+layout (location = 2) in vec2 i_pos;
+layout (location = 3) in vec4 i_uv_rect;
+layout (location = 4) in vec4 i_color;
+
+out vec2 v_texCoord;
+out vec4 v_color;
+
+uniform vs_params {
+    mat4 u_trans;
+};
+
+void main() {
+    vec2 pos = i_pos + i_axes.xy * a_corner.x + i_axes.zw * a_corner.y;
+    v_texCoord = mix(i_uv_rect.xy, i_uv_rect.zw, a_corner);
+    v_color = i_color;
+    gl_Position = u_trans * vec4(pos.x, pos.y, 0.0, 1.0);
+}
+#pragma sokol @end
+
+#pragma sokol @program sprite_instanced vs_instanced fs
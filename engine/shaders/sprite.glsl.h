@@ -24,10 +24,29 @@
                     Component Type: SG_SAMPLERTYPE_FLOAT
                     Bind slot: SLOT_u_tex = 0
 
+        Shader program 'sprite_instanced':
+            Get shader desc: sprite_instanced_shader_desc(sg_query_backend());
+            Vertex shader: vs_instanced
+                Attribute slots:
+                    ATTR_vs_instanced_a_corner = 0
+                    ATTR_vs_instanced_i_axes = 1
+                    ATTR_vs_instanced_i_pos = 2
+                    ATTR_vs_instanced_i_uv_rect = 3
+                    ATTR_vs_instanced_i_color = 4
+                Uniform block 'vs_params':
+                    C struct: vs_params_t
+                    Bind slot: SLOT_vs_params = 0
+            Fragment shader: fs
+                Image 'u_tex':
+                    Type: SG_IMAGETYPE_2D
+                    Component Type: SG_SAMPLERTYPE_FLOAT
+                    Bind slot: SLOT_u_tex = 0
+
 
     Shader descriptor structs:
 
         sg_shader sprite = sg_make_shader(sprite_shader_desc(sg_query_backend()));
+        sg_shader sprite_instanced = sg_make_shader(sprite_instanced_shader_desc(sg_query_backend()));
 
     Vertex attribute locations for vertex shader 'vs':
 
@@ -41,6 +60,20 @@
             },
             ...});
 
+    Vertex attribute locations for vertex shader 'vs_instanced':
+
+        sg_pipeline pip = sg_make_pipeline(&(sg_pipeline_desc){
+            .layout = {
+                .attrs = {
+                    [ATTR_vs_instanced_a_corner] = { ... },
+                    [ATTR_vs_instanced_i_axes] = { ... },
+                    [ATTR_vs_instanced_i_pos] = { ... },
+                    [ATTR_vs_instanced_i_uv_rect] = { ... },
+                    [ATTR_vs_instanced_i_color] = { ... },
+                },
+            },
+            ...});
+
     Image bind slots, use as index in sg_bindings.vs_images[] or .fs_images[]
 
         SLOT_u_tex = 0;
@@ -67,6 +100,11 @@
 #define ATTR_vs_a_pos (0)
 #define ATTR_vs_a_uv (1)
 #define ATTR_vs_a_color (2)
+#define ATTR_vs_instanced_a_corner (0)
+#define ATTR_vs_instanced_i_axes (1)
+#define ATTR_vs_instanced_i_pos (2)
+#define ATTR_vs_instanced_i_uv_rect (3)
+#define ATTR_vs_instanced_i_color (4)
 #define SLOT_u_tex (0)
 #define SLOT_vs_params (0)
 #pragma pack(push,1)
@@ -147,6 +185,65 @@ static const char fs_source_glsl330[183] = {
     0x5f,0x74,0x65,0x78,0x2c,0x20,0x76,0x5f,0x74,0x65,0x78,0x43,0x6f,0x6f,0x72,0x64,
     0x29,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
 };
+/*
+    #version 330
+    
+    uniform vec4 vs_params[4];
+    layout(location = 2) in vec2 i_pos;
+    layout(location = 1) in vec4 i_axes;
+    layout(location = 0) in vec2 a_corner;
+    out vec2 v_texCoord;
+    layout(location = 3) in vec4 i_uv_rect;
+    out vec4 v_color;
+    layout(location = 4) in vec4 i_color;
+    
+    void main()
+    {
+        vec2 pos = (i_pos + (i_axes.xy * a_corner.x)) + (i_axes.zw * a_corner.y);
+        v_texCoord = mix(i_uv_rect.xy, i_uv_rect.zw, a_corner);
+        v_color = i_color;
+        gl_Position = mat4(vs_params[0], vs_params[1], vs_params[2], vs_params[3]) * vec4(pos.x, pos.y, 0.0, 1.0);
+    }
+    
+*/
+static const char vs_instanced_source_glsl330[561] = {
+    0x23,0x76,0x65,0x72,0x73,0x69,0x6f,0x6e,0x20,0x33,0x33,0x30,0x0a,0x0a,0x75,0x6e,
+    0x69,0x66,0x6f,0x72,0x6d,0x20,0x76,0x65,0x63,0x34,0x20,0x76,0x73,0x5f,0x70,0x61,
+    0x72,0x61,0x6d,0x73,0x5b,0x34,0x5d,0x3b,0x0a,0x6c,0x61,0x79,0x6f,0x75,0x74,0x28,
+    0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x32,0x29,0x20,0x69,0x6e,
+    0x20,0x76,0x65,0x63,0x32,0x20,0x69,0x5f,0x70,0x6f,0x73,0x3b,0x0a,0x6c,0x61,0x79,
+    0x6f,0x75,0x74,0x28,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x31,
+    0x29,0x20,0x69,0x6e,0x20,0x76,0x65,0x63,0x34,0x20,0x69,0x5f,0x61,0x78,0x65,0x73,
+    0x3b,0x0a,0x6c,0x61,0x79,0x6f,0x75,0x74,0x28,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,
+    0x6e,0x20,0x3d,0x20,0x30,0x29,0x20,0x69,0x6e,0x20,0x76,0x65,0x63,0x32,0x20,0x61,
+    0x5f,0x63,0x6f,0x72,0x6e,0x65,0x72,0x3b,0x0a,0x6f,0x75,0x74,0x20,0x76,0x65,0x63,
+    0x32,0x20,0x76,0x5f,0x74,0x65,0x78,0x43,0x6f,0x6f,0x72,0x64,0x3b,0x0a,0x6c,0x61,
+    0x79,0x6f,0x75,0x74,0x28,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,
+    0x33,0x29,0x20,0x69,0x6e,0x20,0x76,0x65,0x63,0x34,0x20,0x69,0x5f,0x75,0x76,0x5f,
+    0x72,0x65,0x63,0x74,0x3b,0x0a,0x6f,0x75,0x74,0x20,0x76,0x65,0x63,0x34,0x20,0x76,
+    0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x6c,0x61,0x79,0x6f,0x75,0x74,0x28,0x6c,
+    0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x34,0x29,0x20,0x69,0x6e,0x20,
+    0x76,0x65,0x63,0x34,0x20,0x69,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x0a,0x76,
+    0x6f,0x69,0x64,0x20,0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,
+    0x20,0x76,0x65,0x63,0x32,0x20,0x70,0x6f,0x73,0x20,0x3d,0x20,0x28,0x69,0x5f,0x70,
+    0x6f,0x73,0x20,0x2b,0x20,0x28,0x69,0x5f,0x61,0x78,0x65,0x73,0x2e,0x78,0x79,0x20,
+    0x2a,0x20,0x61,0x5f,0x63,0x6f,0x72,0x6e,0x65,0x72,0x2e,0x78,0x29,0x29,0x20,0x2b,
+    0x20,0x28,0x69,0x5f,0x61,0x78,0x65,0x73,0x2e,0x7a,0x77,0x20,0x2a,0x20,0x61,0x5f,
+    0x63,0x6f,0x72,0x6e,0x65,0x72,0x2e,0x79,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x76,
+    0x5f,0x74,0x65,0x78,0x43,0x6f,0x6f,0x72,0x64,0x20,0x3d,0x20,0x6d,0x69,0x78,0x28,
+    0x69,0x5f,0x75,0x76,0x5f,0x72,0x65,0x63,0x74,0x2e,0x78,0x79,0x2c,0x20,0x69,0x5f,
+    0x75,0x76,0x5f,0x72,0x65,0x63,0x74,0x2e,0x7a,0x77,0x2c,0x20,0x61,0x5f,0x63,0x6f,
+    0x72,0x6e,0x65,0x72,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x76,0x5f,0x63,0x6f,0x6c,
+    0x6f,0x72,0x20,0x3d,0x20,0x69,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,
+    0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,
+    0x6d,0x61,0x74,0x34,0x28,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x5b,0x30,
+    0x5d,0x2c,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x5b,0x31,0x5d,0x2c,
+    0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x5b,0x32,0x5d,0x2c,0x20,0x76,
+    0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x5b,0x33,0x5d,0x29,0x20,0x2a,0x20,0x76,
+    0x65,0x63,0x34,0x28,0x70,0x6f,0x73,0x2e,0x78,0x2c,0x20,0x70,0x6f,0x73,0x2e,0x79,
+    0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x7d,0x0a,0x0a,
+    0x00,
+};
 /*
     cbuffer vs_params : register(b0)
     {
@@ -357,6 +454,162 @@ static const char fs_source_hlsl5[726] = {
     0x74,0x75,0x72,0x6e,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,
     0x74,0x3b,0x0a,0x7d,0x0a,0x00,
 };
+/*
+    cbuffer vs_params : register(b0)
+    {
+        row_major float4x4 _75_u_trans : packoffset(c0);
+    };
+    
+    
+    static float4 gl_Position;
+    static float2 i_pos;
+    static float4 i_axes;
+    static float2 a_corner;
+    static float2 v_texCoord;
+    static float4 i_uv_rect;
+    static float4 v_color;
+    static float4 i_color;
+    
+    struct SPIRV_Cross_Input
+    {
+        float2 a_corner : TEXCOORD0;
+        float4 i_axes : TEXCOORD1;
+        float2 i_pos : TEXCOORD2;
+        float4 i_uv_rect : TEXCOORD3;
+        float4 i_color : TEXCOORD4;
+    };
+    
+    struct SPIRV_Cross_Output
+    {
+        float2 v_texCoord : TEXCOORD0;
+        float4 v_color : TEXCOORD1;
+        float4 gl_Position : SV_Position;
+    };
+    
+    #line 56 "engine/shaders/sprite.glsl"
+    void vert_main()
+    {
+    #line 56 "engine/shaders/sprite.glsl"
+        float2 pos = (i_pos + (i_axes.xy * a_corner.x)) + (i_axes.zw * a_corner.y);
+    #line 57 "engine/shaders/sprite.glsl"
+        v_texCoord = lerp(i_uv_rect.xy, i_uv_rect.zw, a_corner);
+    #line 58 "engine/shaders/sprite.glsl"
+        v_color = i_color;
+    #line 59 "engine/shaders/sprite.glsl"
+        gl_Position = mul(float4(pos.x, pos.y, 0.0f, 1.0f), _75_u_trans);
+    }
+    
+    SPIRV_Cross_Output main(SPIRV_Cross_Input stage_input)
+    {
+        i_pos = stage_input.i_pos;
+        i_axes = stage_input.i_axes;
+        a_corner = stage_input.a_corner;
+        i_uv_rect = stage_input.i_uv_rect;
+        i_color = stage_input.i_color;
+        vert_main();
+        SPIRV_Cross_Output stage_output;
+        stage_output.gl_Position = gl_Position;
+        stage_output.v_texCoord = v_texCoord;
+        stage_output.v_color = v_color;
+        return stage_output;
+    }
+*/
+static const char vs_instanced_source_hlsl5[1495] = {
+    0x63,0x62,0x75,0x66,0x66,0x65,0x72,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,
+    0x73,0x20,0x3a,0x20,0x72,0x65,0x67,0x69,0x73,0x74,0x65,0x72,0x28,0x62,0x30,0x29,
+    0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x72,0x6f,0x77,0x5f,0x6d,0x61,0x6a,0x6f,0x72,
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x5f,0x37,0x35,0x5f,0x75,0x5f,
+    0x74,0x72,0x61,0x6e,0x73,0x20,0x3a,0x20,0x70,0x61,0x63,0x6b,0x6f,0x66,0x66,0x73,
+    0x65,0x74,0x28,0x63,0x30,0x29,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x0a,0x73,0x74,0x61,
+    0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,
+    0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x32,0x20,0x69,0x5f,0x70,0x6f,0x73,0x3b,0x0a,0x73,0x74,0x61,
+    0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x5f,0x61,0x78,0x65,
+    0x73,0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,
+    0x20,0x61,0x5f,0x63,0x6f,0x72,0x6e,0x65,0x72,0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,
+    0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x76,0x5f,0x74,0x65,0x78,0x43,0x6f,
+    0x6f,0x72,0x64,0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x20,0x69,0x5f,0x75,0x76,0x5f,0x72,0x65,0x63,0x74,0x3b,0x0a,0x73,0x74,
+    0x61,0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x76,0x5f,0x63,0x6f,
+    0x6c,0x6f,0x72,0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x20,0x69,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x0a,0x73,0x74,0x72,
+    0x75,0x63,0x74,0x20,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,
+    0x49,0x6e,0x70,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x32,0x20,0x61,0x5f,0x63,0x6f,0x72,0x6e,0x65,0x72,0x20,0x3a,0x20,0x54,0x45,
+    0x58,0x43,0x4f,0x4f,0x52,0x44,0x30,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,
+    0x61,0x74,0x34,0x20,0x69,0x5f,0x61,0x78,0x65,0x73,0x20,0x3a,0x20,0x54,0x45,0x58,
+    0x43,0x4f,0x4f,0x52,0x44,0x31,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x32,0x20,0x69,0x5f,0x70,0x6f,0x73,0x20,0x3a,0x20,0x54,0x45,0x58,0x43,0x4f,
+    0x4f,0x52,0x44,0x32,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x20,0x69,0x5f,0x75,0x76,0x5f,0x72,0x65,0x63,0x74,0x20,0x3a,0x20,0x54,0x45,0x58,
+    0x43,0x4f,0x4f,0x52,0x44,0x33,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x20,0x69,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x54,0x45,0x58,
+    0x43,0x4f,0x4f,0x52,0x44,0x34,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,
+    0x63,0x74,0x20,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,
+    0x75,0x74,0x70,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x32,0x20,0x76,0x5f,0x74,0x65,0x78,0x43,0x6f,0x6f,0x72,0x64,0x20,0x3a,0x20,
+    0x54,0x45,0x58,0x43,0x4f,0x4f,0x52,0x44,0x30,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x76,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,
+    0x54,0x45,0x58,0x43,0x4f,0x4f,0x52,0x44,0x31,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,
+    0x6e,0x20,0x3a,0x20,0x53,0x56,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,
+    0x0a,0x7d,0x3b,0x0a,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x35,0x36,0x20,0x22,0x65,
+    0x6e,0x67,0x69,0x6e,0x65,0x2f,0x73,0x68,0x61,0x64,0x65,0x72,0x73,0x2f,0x73,0x70,
+    0x72,0x69,0x74,0x65,0x2e,0x67,0x6c,0x73,0x6c,0x22,0x0a,0x76,0x6f,0x69,0x64,0x20,
+    0x76,0x65,0x72,0x74,0x5f,0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,0x7b,0x0a,0x23,0x6c,
+    0x69,0x6e,0x65,0x20,0x35,0x36,0x20,0x22,0x65,0x6e,0x67,0x69,0x6e,0x65,0x2f,0x73,
+    0x68,0x61,0x64,0x65,0x72,0x73,0x2f,0x73,0x70,0x72,0x69,0x74,0x65,0x2e,0x67,0x6c,
+    0x73,0x6c,0x22,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x70,
+    0x6f,0x73,0x20,0x3d,0x20,0x28,0x69,0x5f,0x70,0x6f,0x73,0x20,0x2b,0x20,0x28,0x69,
+    0x5f,0x61,0x78,0x65,0x73,0x2e,0x78,0x79,0x20,0x2a,0x20,0x61,0x5f,0x63,0x6f,0x72,
+    0x6e,0x65,0x72,0x2e,0x78,0x29,0x29,0x20,0x2b,0x20,0x28,0x69,0x5f,0x61,0x78,0x65,
+    0x73,0x2e,0x7a,0x77,0x20,0x2a,0x20,0x61,0x5f,0x63,0x6f,0x72,0x6e,0x65,0x72,0x2e,
+    0x79,0x29,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x35,0x37,0x20,0x22,0x65,0x6e,
+    0x67,0x69,0x6e,0x65,0x2f,0x73,0x68,0x61,0x64,0x65,0x72,0x73,0x2f,0x73,0x70,0x72,
+    0x69,0x74,0x65,0x2e,0x67,0x6c,0x73,0x6c,0x22,0x0a,0x20,0x20,0x20,0x20,0x76,0x5f,
+    0x74,0x65,0x78,0x43,0x6f,0x6f,0x72,0x64,0x20,0x3d,0x20,0x6c,0x65,0x72,0x70,0x28,
+    0x69,0x5f,0x75,0x76,0x5f,0x72,0x65,0x63,0x74,0x2e,0x78,0x79,0x2c,0x20,0x69,0x5f,
+    0x75,0x76,0x5f,0x72,0x65,0x63,0x74,0x2e,0x7a,0x77,0x2c,0x20,0x61,0x5f,0x63,0x6f,
+    0x72,0x6e,0x65,0x72,0x29,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x35,0x38,0x20,
+    0x22,0x65,0x6e,0x67,0x69,0x6e,0x65,0x2f,0x73,0x68,0x61,0x64,0x65,0x72,0x73,0x2f,
+    0x73,0x70,0x72,0x69,0x74,0x65,0x2e,0x67,0x6c,0x73,0x6c,0x22,0x0a,0x20,0x20,0x20,
+    0x20,0x76,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x69,0x5f,0x63,0x6f,0x6c,
+    0x6f,0x72,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x35,0x39,0x20,0x22,0x65,0x6e,
+    0x67,0x69,0x6e,0x65,0x2f,0x73,0x68,0x61,0x64,0x65,0x72,0x73,0x2f,0x73,0x70,0x72,
+    0x69,0x74,0x65,0x2e,0x67,0x6c,0x73,0x6c,0x22,0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,
+    0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x6d,0x75,0x6c,0x28,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x70,0x6f,0x73,0x2e,0x78,0x2c,0x20,0x70,0x6f,
+    0x73,0x2e,0x79,0x2c,0x20,0x30,0x2e,0x30,0x66,0x2c,0x20,0x31,0x2e,0x30,0x66,0x29,
+    0x2c,0x20,0x5f,0x37,0x35,0x5f,0x75,0x5f,0x74,0x72,0x61,0x6e,0x73,0x29,0x3b,0x0a,
+    0x7d,0x0a,0x0a,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,
+    0x75,0x74,0x70,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x28,0x53,0x50,0x49,0x52,0x56,
+    0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x49,0x6e,0x70,0x75,0x74,0x20,0x73,0x74,0x61,
+    0x67,0x65,0x5f,0x69,0x6e,0x70,0x75,0x74,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,
+    0x69,0x5f,0x70,0x6f,0x73,0x20,0x3d,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,
+    0x70,0x75,0x74,0x2e,0x69,0x5f,0x70,0x6f,0x73,0x3b,0x0a,0x20,0x20,0x20,0x20,0x69,
+    0x5f,0x61,0x78,0x65,0x73,0x20,0x3d,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,
+    0x70,0x75,0x74,0x2e,0x69,0x5f,0x61,0x78,0x65,0x73,0x3b,0x0a,0x20,0x20,0x20,0x20,
+    0x61,0x5f,0x63,0x6f,0x72,0x6e,0x65,0x72,0x20,0x3d,0x20,0x73,0x74,0x61,0x67,0x65,
+    0x5f,0x69,0x6e,0x70,0x75,0x74,0x2e,0x61,0x5f,0x63,0x6f,0x72,0x6e,0x65,0x72,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x69,0x5f,0x75,0x76,0x5f,0x72,0x65,0x63,0x74,0x20,0x3d,
+    0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x70,0x75,0x74,0x2e,0x69,0x5f,0x75,
+    0x76,0x5f,0x72,0x65,0x63,0x74,0x3b,0x0a,0x20,0x20,0x20,0x20,0x69,0x5f,0x63,0x6f,
+    0x6c,0x6f,0x72,0x20,0x3d,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x70,0x75,
+    0x74,0x2e,0x69,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,0x20,0x76,
+    0x65,0x72,0x74,0x5f,0x6d,0x61,0x69,0x6e,0x28,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,
+    0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,0x75,0x74,0x70,
+    0x75,0x74,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,0x74,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,
+    0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,
+    0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,0x74,0x2e,0x76,0x5f,
+    0x74,0x65,0x78,0x43,0x6f,0x6f,0x72,0x64,0x20,0x3d,0x20,0x76,0x5f,0x74,0x65,0x78,
+    0x43,0x6f,0x6f,0x72,0x64,0x3b,0x0a,0x20,0x20,0x20,0x20,0x73,0x74,0x61,0x67,0x65,
+    0x5f,0x6f,0x75,0x74,0x70,0x75,0x74,0x2e,0x76,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x20,
+    0x3d,0x20,0x76,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,
+    0x65,0x74,0x75,0x72,0x6e,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,
+    0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x00,
+};
 /*
     #include <metal_stdlib>
     #include <simd/simd.h>
@@ -512,6 +765,117 @@ static const char fs_source_metal_macos[540] = {
     0x43,0x6f,0x6f,0x72,0x64,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,0x75,
     0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
 };
+/*
+    #include <metal_stdlib>
+    #include <simd/simd.h>
+    
+    using namespace metal;
+    
+    struct vs_params
+    {
+        float4x4 u_trans;
+    };
+    
+    struct main0_out
+    {
+        float2 v_texCoord [[user(locn0)]];
+        float4 v_color [[user(locn1)]];
+        float4 gl_Position [[position]];
+    };
+    
+    struct main0_in
+    {
+        float2 a_corner [[attribute(0)]];
+        float4 i_axes [[attribute(1)]];
+        float2 i_pos [[attribute(2)]];
+        float4 i_uv_rect [[attribute(3)]];
+        float4 i_color [[attribute(4)]];
+    };
+    
+    #line 56 "engine/shaders/sprite.glsl"
+    vertex main0_out main0(main0_in in [[stage_in]], constant vs_params& _75 [[buffer(0)]])
+    {
+        main0_out out = {};
+    #line 56 "engine/shaders/sprite.glsl"
+        float2 pos = (in.i_pos + (in.i_axes.xy * in.a_corner.x)) + (in.i_axes.zw * in.a_corner.y);
+    #line 57 "engine/shaders/sprite.glsl"
+        out.v_texCoord = mix(in.i_uv_rect.xy, in.i_uv_rect.zw, in.a_corner);
+    #line 58 "engine/shaders/sprite.glsl"
+        out.v_color = in.i_color;
+    #line 59 "engine/shaders/sprite.glsl"
+        out.gl_Position = _75.u_trans * float4(pos.x, pos.y, 0.0, 1.0);
+        return out;
+    }
+    
+*/
+static const char vs_instanced_source_metal_macos[1049] = {
+    0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,0x20,0x3c,0x6d,0x65,0x74,0x61,0x6c,0x5f,
+    0x73,0x74,0x64,0x6c,0x69,0x62,0x3e,0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,
+    0x20,0x3c,0x73,0x69,0x6d,0x64,0x2f,0x73,0x69,0x6d,0x64,0x2e,0x68,0x3e,0x0a,0x0a,
+    0x75,0x73,0x69,0x6e,0x67,0x20,0x6e,0x61,0x6d,0x65,0x73,0x70,0x61,0x63,0x65,0x20,
+    0x6d,0x65,0x74,0x61,0x6c,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x76,
+    0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x75,0x5f,0x74,0x72,0x61,0x6e,0x73,0x3b,
+    0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,
+    0x30,0x5f,0x6f,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x32,0x20,0x76,0x5f,0x74,0x65,0x78,0x43,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,
+    0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,
+    0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x76,0x5f,0x63,0x6f,0x6c,0x6f,
+    0x72,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x31,0x29,0x5d,
+    0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x67,0x6c,
+    0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x70,0x6f,0x73,0x69,
+    0x74,0x69,0x6f,0x6e,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,
+    0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x0a,0x7b,0x0a,0x20,0x20,
+    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x61,0x5f,0x63,0x6f,0x72,0x6e,0x65,
+    0x72,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x30,0x29,
+    0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,
+    0x5f,0x61,0x78,0x65,0x73,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,
+    0x65,0x28,0x31,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x32,0x20,0x69,0x5f,0x70,0x6f,0x73,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,
+    0x62,0x75,0x74,0x65,0x28,0x32,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x5f,0x75,0x76,0x5f,0x72,0x65,0x63,0x74,0x20,
+    0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x33,0x29,0x5d,0x5d,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x5f,0x63,
+    0x6f,0x6c,0x6f,0x72,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,
+    0x28,0x34,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x23,0x6c,0x69,0x6e,0x65,
+    0x20,0x35,0x36,0x20,0x22,0x65,0x6e,0x67,0x69,0x6e,0x65,0x2f,0x73,0x68,0x61,0x64,
+    0x65,0x72,0x73,0x2f,0x73,0x70,0x72,0x69,0x74,0x65,0x2e,0x67,0x6c,0x73,0x6c,0x22,
+    0x0a,0x76,0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,
+    0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,
+    0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x5d,0x5d,
+    0x2c,0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,0x20,0x76,0x73,0x5f,0x70,0x61,
+    0x72,0x61,0x6d,0x73,0x26,0x20,0x5f,0x37,0x35,0x20,0x5b,0x5b,0x62,0x75,0x66,0x66,
+    0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,
+    0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,
+    0x7d,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x35,0x36,0x20,0x22,0x65,0x6e,0x67,
+    0x69,0x6e,0x65,0x2f,0x73,0x68,0x61,0x64,0x65,0x72,0x73,0x2f,0x73,0x70,0x72,0x69,
+    0x74,0x65,0x2e,0x67,0x6c,0x73,0x6c,0x22,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,
+    0x61,0x74,0x32,0x20,0x70,0x6f,0x73,0x20,0x3d,0x20,0x28,0x69,0x6e,0x2e,0x69,0x5f,
+    0x70,0x6f,0x73,0x20,0x2b,0x20,0x28,0x69,0x6e,0x2e,0x69,0x5f,0x61,0x78,0x65,0x73,
+    0x2e,0x78,0x79,0x20,0x2a,0x20,0x69,0x6e,0x2e,0x61,0x5f,0x63,0x6f,0x72,0x6e,0x65,
+    0x72,0x2e,0x78,0x29,0x29,0x20,0x2b,0x20,0x28,0x69,0x6e,0x2e,0x69,0x5f,0x61,0x78,
+    0x65,0x73,0x2e,0x7a,0x77,0x20,0x2a,0x20,0x69,0x6e,0x2e,0x61,0x5f,0x63,0x6f,0x72,
+    0x6e,0x65,0x72,0x2e,0x79,0x29,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x35,0x37,
+    0x20,0x22,0x65,0x6e,0x67,0x69,0x6e,0x65,0x2f,0x73,0x68,0x61,0x64,0x65,0x72,0x73,
+    0x2f,0x73,0x70,0x72,0x69,0x74,0x65,0x2e,0x67,0x6c,0x73,0x6c,0x22,0x0a,0x20,0x20,
+    0x20,0x20,0x6f,0x75,0x74,0x2e,0x76,0x5f,0x74,0x65,0x78,0x43,0x6f,0x6f,0x72,0x64,
+    0x20,0x3d,0x20,0x6d,0x69,0x78,0x28,0x69,0x6e,0x2e,0x69,0x5f,0x75,0x76,0x5f,0x72,
+    0x65,0x63,0x74,0x2e,0x78,0x79,0x2c,0x20,0x69,0x6e,0x2e,0x69,0x5f,0x75,0x76,0x5f,
+    0x72,0x65,0x63,0x74,0x2e,0x7a,0x77,0x2c,0x20,0x69,0x6e,0x2e,0x61,0x5f,0x63,0x6f,
+    0x72,0x6e,0x65,0x72,0x29,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x35,0x38,0x20,
+    0x22,0x65,0x6e,0x67,0x69,0x6e,0x65,0x2f,0x73,0x68,0x61,0x64,0x65,0x72,0x73,0x2f,
+    0x73,0x70,0x72,0x69,0x74,0x65,0x2e,0x67,0x6c,0x73,0x6c,0x22,0x0a,0x20,0x20,0x20,
+    0x20,0x6f,0x75,0x74,0x2e,0x76,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x69,
+    0x6e,0x2e,0x69,0x5f,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,
+    0x20,0x35,0x39,0x20,0x22,0x65,0x6e,0x67,0x69,0x6e,0x65,0x2f,0x73,0x68,0x61,0x64,
+    0x65,0x72,0x73,0x2f,0x73,0x70,0x72,0x69,0x74,0x65,0x2e,0x67,0x6c,0x73,0x6c,0x22,
+    0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,
+    0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x5f,0x37,0x35,0x2e,0x75,0x5f,0x74,0x72,0x61,
+    0x6e,0x73,0x20,0x2a,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x70,0x6f,0x73,0x2e,
+    0x78,0x2c,0x20,0x70,0x6f,0x73,0x2e,0x79,0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,
+    0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,
+    0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+};
 #if !defined(SOKOL_GFX_INCLUDED)
   #error "Please include sokol_gfx.h before sprite.glsl.h"
 #endif
@@ -586,3 +950,80 @@ static inline const sg_shader_desc* sprite_shader_desc(sg_backend backend) {
   }
   return 0;
 }
+static inline const sg_shader_desc* sprite_instanced_shader_desc(sg_backend backend) {
+  if (backend == SG_BACKEND_GLCORE33) {
+    static sg_shader_desc desc;
+    static bool valid;
+    if (!valid) {
+      valid = true;
+      desc.attrs[0].name = "a_corner";
+      desc.attrs[1].name = "i_axes";
+      desc.attrs[2].name = "i_pos";
+      desc.attrs[3].name = "i_uv_rect";
+      desc.attrs[4].name = "i_color";
+      desc.vs.source = vs_instanced_source_glsl330;
+      desc.vs.entry = "main";
+      desc.vs.uniform_blocks[0].size = 64;
+      desc.vs.uniform_blocks[0].layout = SG_UNIFORMLAYOUT_STD140;
+      desc.vs.uniform_blocks[0].uniforms[0].name = "vs_params";
+      desc.vs.uniform_blocks[0].uniforms[0].type = SG_UNIFORMTYPE_FLOAT4;
+      desc.vs.uniform_blocks[0].uniforms[0].array_count = 4;
+      desc.fs.source = fs_source_glsl330;
+      desc.fs.entry = "main";
+      desc.fs.images[0].name = "u_tex";
+      desc.fs.images[0].image_type = SG_IMAGETYPE_2D;
+      desc.fs.images[0].sampler_type = SG_SAMPLERTYPE_FLOAT;
+      desc.label = "sprite_instanced_shader";
+    }
+    return &desc;
+  }
+  if (backend == SG_BACKEND_D3D11) {
+    static sg_shader_desc desc;
+    static bool valid;
+    if (!valid) {
+      valid = true;
+      desc.attrs[0].sem_name = "TEXCOORD";
+      desc.attrs[0].sem_index = 0;
+      desc.attrs[1].sem_name = "TEXCOORD";
+      desc.attrs[1].sem_index = 1;
+      desc.attrs[2].sem_name = "TEXCOORD";
+      desc.attrs[2].sem_index = 2;
+      desc.attrs[3].sem_name = "TEXCOORD";
+      desc.attrs[3].sem_index = 3;
+      desc.attrs[4].sem_name = "TEXCOORD";
+      desc.attrs[4].sem_index = 4;
+      desc.vs.source = vs_instanced_source_hlsl5;
+      desc.vs.d3d11_target = "vs_5_0";
+      desc.vs.entry = "main";
+      desc.vs.uniform_blocks[0].size = 64;
+      desc.vs.uniform_blocks[0].layout = SG_UNIFORMLAYOUT_STD140;
+      desc.fs.source = fs_source_hlsl5;
+      desc.fs.d3d11_target = "ps_5_0";
+      desc.fs.entry = "main";
+      desc.fs.images[0].name = "u_tex";
+      desc.fs.images[0].image_type = SG_IMAGETYPE_2D;
+      desc.fs.images[0].sampler_type = SG_SAMPLERTYPE_FLOAT;
+      desc.label = "sprite_instanced_shader";
+    }
+    return &desc;
+  }
+  if (backend == SG_BACKEND_METAL_MACOS) {
+    static sg_shader_desc desc;
+    static bool valid;
+    if (!valid) {
+      valid = true;
+      desc.vs.source = vs_instanced_source_metal_macos;
+      desc.vs.entry = "main0";
+      desc.vs.uniform_blocks[0].size = 64;
+      desc.vs.uniform_blocks[0].layout = SG_UNIFORMLAYOUT_STD140;
+      desc.fs.source = fs_source_metal_macos;
+      desc.fs.entry = "main0";
+      desc.fs.images[0].name = "u_tex";
+      desc.fs.images[0].image_type = SG_IMAGETYPE_2D;
+      desc.fs.images[0].sampler_type = SG_SAMPLERTYPE_FLOAT;
+      desc.label = "sprite_instanced_shader";
+    }
+    return &desc;
+  }
+  return 0;
+}
@@ -161,6 +161,13 @@ inline SQInteger get_value(HSQUIRRELVM vm, SQInteger index, Table& value){
     return SQ_OK;
 }
 
+// The array isn't addref'd, so it's only valid while it stays on the stack (ex. as a function argument).
+template<>
+inline SQInteger get_value(HSQUIRRELVM vm, SQInteger index, Array& value){
+    SQ_EXPECT(sq_getstackobj(vm, index, &value.obj), "Could not get Array from squirrel stack")
+    return SQ_OK;
+}
+
 #define GET_VALUE_INTEGER(TYPE) \
 template<> \
 inline SQInteger get_value(HSQUIRRELVM vm, SQInteger index, TYPE& value) { \
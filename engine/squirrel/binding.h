@@ -93,9 +93,17 @@ static Ref<T> default_class_allocator() {
 template <class T>
 static SQInteger default_class_deallocator(SQUserPointer ptr, SQInteger size) {
     if constexpr (is_resource_v<T>) {
+        // The GC can run in the middle of iterating the pool, so release the item at the end of the frame
         auto ref = Ref<T>(reinterpret_cast<uintptr_t>(ptr));
-        if (Engine::instance().get_resources()->template get_pool<T>().release(ref)) return SQ_OK;
-        else return SQ_ERROR;
+        auto& pool = Engine::instance().get_resources()->template get_pool<T>();
+        if constexpr (is_scriptable_v<T>) {
+            // The squirrel instance is gone now, so the pending update/render calls must not use it
+            if (auto item = pool.try_get(ref)) {
+                item->detach_script();
+            }
+        }
+        pool.release_deferred(ref);
+        return SQ_OK;
     }
     else {
         delete reinterpret_cast<T*>(ptr);
@@ -22,6 +22,14 @@ public:
 
     void register_script_methods(SQInteger instance_idx);
 
+    // Forgets the script instance once squirrel frees it (the handles are weak), so update() and render()
+    // do nothing until the deferred release of this item.
+    void detach_script() {
+        instance.reset();
+        on_update.reset();
+        on_render.reset();
+    }
+
     void update(VM& vm, float dt);
 
     void render(VM& vm);
@@ -0,0 +1,75 @@
+//
+// Created by user on 2026-10-17.
+//
+
+#include "doctest.h"
+
+#include <cstdint>
+
+#include "core/arena_allocator.h"
+
+TEST_CASE("Testing arena_allocator - alignment and reset") {
+    arena_allocator arena(1024);
+
+    void* a = arena.allocate(3, 1, 0);
+    void* b = arena.allocate(8, 64, 0);
+    void* c = arena.allocate(4, 16, 4);
+    CHECK(a != b);
+    CHECK(reinterpret_cast<uintptr_t>(b) % 64 == 0);
+    CHECK((reinterpret_cast<uintptr_t>(c) + 4) % 16 == 0);
+    CHECK(arena.block_count() == 1);
+
+    arena.reset();
+    CHECK(arena.used_bytes() == 0);
+    CHECK(arena.allocate(3, 1, 0) == a);
+}
+
+TEST_CASE("Testing arena_allocator - overflow chaining") {
+    arena_allocator arena(256);
+
+    // Overflowing chains new blocks instead of running past the end
+    std::vector<uint8_t*> ptrs;
+    for (int i = 0; i < 100; i++) {
+        auto ptr = static_cast<uint8_t*>(arena.allocate(100, 8, 0));
+        for (int j = 0; j < 100; j++) ptr[j] = (uint8_t)i;
+        ptrs.push_back(ptr);
+    }
+    CHECK(arena.block_count() > 1);
+    CHECK(arena.used_bytes() >= 100 * 100);
+    for (int i = 0; i < 100; i++) {
+        CHECK(ptrs[i][0] == i);
+        CHECK(ptrs[i][99] == i);
+    }
+
+    // After a reset the chain is merged, so the same frame fits in one block
+    arena.reset();
+    CHECK(arena.block_count() == 1);
+    for (int i = 0; i < 100; i++) {
+        arena.allocate(100, 8, 0);
+    }
+    CHECK(arena.block_count() == 1);
+}
+
+TEST_CASE("Testing frame_arena - double buffering and STL adapter") {
+    frame_arena frames(1024);
+
+    arena_vector<int> prev_frame(&frames.get());
+    for (int i = 0; i < 1000; i++) {
+        prev_frame.push_back(i);
+    }
+
+    // Memory of the previous frame stays valid for one more frame
+    frames.next_frame();
+    arena_vector<int> cur_frame(&frames.get());
+    cur_frame.reserve(1000);
+    for (int i = 0; i < 1000; i++) {
+        cur_frame.push_back(-i);
+    }
+    for (int i = 0; i < 1000; i++) {
+        CHECK(prev_frame[i] == i);
+    }
+    CHECK(&frames.get_previous() == prev_frame.get_allocator().arena);
+
+    frames.next_frame();
+    CHECK(frames.get().used_bytes() == 0);
+}
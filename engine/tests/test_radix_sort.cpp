@@ -0,0 +1,93 @@
+//
+// Created by user on 2026-10-17.
+//
+
+#include "doctest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "core/radix_sort.h"
+#include "core/timer.h"
+
+// Same layout as the sprite renderer's sort entries
+struct SortEntry {
+    uint64_t ref;
+    uint64_t key;
+};
+
+static uint64_t make_sprite_key(std::mt19937_64& rng) {
+    uint64_t layer = rng() % 4, order = rng() % 16, texture = rng() % 64;
+    return (layer << 48) | (order << 32) | texture;
+}
+
+static std::vector<SortEntry> make_entries(size_t n, bool sprite_keys) {
+    std::mt19937_64 rng(1234);
+    std::vector<SortEntry> entries(n);
+    for (size_t i = 0; i < n; i++) {
+        entries[i].ref = i;
+        entries[i].key = sprite_keys ? make_sprite_key(rng) : rng();
+    }
+    return entries;
+}
+
+static void radix_sort_entries(std::vector<SortEntry>& entries) {
+    std::vector<SortEntry> scratch(entries.size());
+    radix_sort(entries.data(), scratch.data(), entries.size(), [](const SortEntry& e) { return e.key; });
+}
+
+TEST_CASE("Testing radix_sort - matches std::stable_sort") {
+    for (bool sprite_keys : {true, false}) {
+        for (size_t n : {0, 1, 2, 100, 5000}) {
+            auto entries = make_entries(n, sprite_keys);
+            auto expected = entries;
+            std::stable_sort(expected.begin(), expected.end(), [](const SortEntry& e1, const SortEntry& e2) {
+                return e1.key < e2.key;
+            });
+            radix_sort_entries(entries);
+            for (size_t i = 0; i < n; i++) {
+                CHECK(entries[i].key == expected[i].key);
+                CHECK(entries[i].ref == expected[i].ref);
+            }
+        }
+    }
+}
+
+TEST_CASE("Testing radix_sort - all keys equal") {
+    std::vector<SortEntry> entries(1000);
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i] = {i, 42};
+    }
+    radix_sort_entries(entries);
+    for (size_t i = 0; i < entries.size(); i++) {
+        CHECK(entries[i].ref == i);
+    }
+}
+
+// Run with --no-skip to compare against the std::sort path the sprite renderer used before
+TEST_CASE("Benchmark radix_sort - sprite order ids" * doctest::skip()) {
+    for (size_t n : {10000, 100000, 500000}) {
+        auto entries = make_entries(n, true);
+
+        auto std_entries = entries;
+        uint64_t start = time_ns();
+        std::sort(std_entries.begin(), std_entries.end(), [](const SortEntry& e1, const SortEntry& e2) {
+            return e1.key < e2.key;
+        });
+        uint64_t std_time = time_ns() - start;
+
+        auto radix_entries = entries;
+        std::vector<SortEntry> scratch(n);
+        start = time_ns();
+        radix_sort(radix_entries.data(), scratch.data(), n, [](const SortEntry& e) { return e.key; });
+        uint64_t radix_time = time_ns() - start;
+
+        printf("%7zu sprites: std::sort %8.3f ms, radix_sort %8.3f ms\n", n, std_time / 1e6, radix_time / 1e6);
+        for (size_t i = 0; i < n; i++) {
+            REQUIRE(std_entries[i].key == radix_entries[i].key);
+        }
+    }
+}
@@ -4,9 +4,11 @@
 
 #include "doctest.h"
 
+#include <algorithm>
 #include <ctime>
 #include <cstdlib>
 #include <random>
+#include <thread>
 
 #include "resource_pool.h"
 
@@ -182,3 +184,400 @@ TEST_CASE("Testing StableResourcePool - complex test 2") {
         }
     }
 }
+
+TEST_CASE("Testing StableResourcePool - dense index") {
+    const int test_size = 1024;
+    auto pool = StableResourcePool<Obj>(test_size);
+    std::vector<Ref<Obj>> refs;
+    for (int i = 0; i < test_size / 2; i++) {
+        refs.push_back(pool.new_item(i));
+    }
+    // Enabling the index later should pick up existing items
+    pool.enable_dense_index();
+
+    std::mt19937 rng(std::random_device{}());
+    for (int iter = 0; iter < 10; iter++) {
+        std::shuffle(refs.begin(), refs.end(), rng);
+        const int delete_size = refs.size() / 2;
+        for (int i = 0; i < delete_size; i++) {
+            pool.release(refs.back());
+            refs.pop_back();
+        }
+        const int add_size = delete_size / 2 + 16;
+        for (int i = 0; i < add_size; i++) {
+            refs.push_back(pool.new_item(iter));
+        }
+
+        std::vector<uintptr_t> expected, visited;
+        for (auto ref : refs) {
+            expected.push_back(ref.addr);
+        }
+        pool.foreach_ref([&](Ref<Obj> ref, Obj& obj) {
+            CHECK(pool.is_valid(ref));
+            visited.push_back(ref.addr);
+        });
+        std::sort(expected.begin(), expected.end());
+        std::sort(visited.begin(), visited.end());
+        CHECK(visited == expected);
+    }
+
+    // Releasing the current item while iterating shouldn't skip any other item
+    int visit_count = 0;
+    int live_count = pool.size();
+    pool.foreach_ref([&](Ref<Obj> ref, Obj& obj) {
+        visit_count++;
+        if (visit_count % 2 == 0) {
+            pool.release(ref);
+        }
+    });
+    CHECK(visit_count == live_count);
+    CHECK(pool.size() == live_count - live_count / 2);
+}
+
+TEST_CASE("Testing StableResourcePool - bulk allocation") {
+    const int test_size = 4096;
+    auto pool = StableResourcePool<Obj>(test_size);
+    pool.enable_dense_index();
+
+    std::vector<Ref<Obj>> refs(1000);
+    pool.new_items(refs.size(), refs.data(), 7);
+    CHECK(pool.size() == 1000);
+    for (auto ref : refs) {
+        CHECK(pool.is_valid(ref));
+        CHECK(*pool.get(ref) == 7);
+    }
+
+    // Release every other item in one batch
+    std::vector<Ref<Obj>> released, kept;
+    for (int i = 0; i < refs.size(); i++) {
+        (i % 2 == 0 ? released : kept).push_back(refs[i]);
+    }
+    pool.release_items(released.data(), released.size());
+    CHECK(pool.size() == kept.size());
+    for (auto ref : released) {
+        CHECK(!pool.is_valid(ref));
+    }
+
+    // The batch should reuse the released slots first, then append new ones
+    std::vector<Ref<Obj>> new_refs(800);
+    pool.new_items_from(new_refs.size(), new_refs.data(), [](uint32_t i) { return Obj(i); });
+    CHECK(pool.size() == kept.size() + new_refs.size());
+    for (int i = 0; i < new_refs.size(); i++) {
+        CHECK(pool.is_valid(new_refs[i]));
+        CHECK(*pool.get(new_refs[i]) == Obj(i));
+    }
+    for (auto ref : kept) {
+        CHECK(pool.is_valid(ref));
+        CHECK(*pool.get(ref) == 7);
+    }
+
+    int visit_count = 0;
+    pool.foreach([&](Obj& obj) { visit_count++; });
+    CHECK(visit_count == pool.size());
+
+    // Single item allocation still works after a batch release
+    pool.release_items(new_refs.data(), new_refs.size());
+    auto a = pool.new_item(42);
+    CHECK(*pool.get(a) == 42);
+    CHECK(pool.size() == kept.size() + 1);
+}
+
+TEST_CASE("Testing StableResourcePool - release with label") {
+    const int test_size = 1024;
+    auto pool = StableResourcePool<Obj>(test_size);
+    ResourceLabel label_a = make_res_label("a");
+    ResourceLabel label_b = make_res_label("b");
+
+    std::vector<Ref<Obj>> refs_a, refs_b;
+    for (int i = 0; i < 300; i++) {
+        pool.set_resource_label(i % 3 == 0 ? label_b : label_a);
+        (i % 3 == 0 ? refs_b : refs_a).push_back(pool.new_item(i));
+    }
+    // Single releases have to keep the label lists consistent too
+    pool.release(refs_a.back());
+    refs_a.pop_back();
+    pool.release(refs_b.front());
+    refs_b.erase(refs_b.begin());
+
+    CHECK(pool.release(label_a) == refs_a.size());
+    CHECK(pool.size() == refs_b.size());
+    for (auto ref : refs_a) {
+        CHECK(!pool.is_valid(ref));
+    }
+    for (auto ref : refs_b) {
+        CHECK(pool.is_valid(ref));
+    }
+    CHECK(pool.release(label_a) == 0);
+
+    // Released slots get reused under the current label
+    pool.set_resource_label(label_a);
+    std::vector<Ref<Obj>> new_refs(50);
+    pool.new_items(new_refs.size(), new_refs.data(), 1);
+    CHECK(pool.release(label_b) == refs_b.size());
+    CHECK(pool.size() == new_refs.size());
+    for (auto ref : new_refs) {
+        CHECK(pool.is_valid(ref));
+    }
+    pool.release_items(new_refs.data(), new_refs.size());
+    CHECK(pool.release(label_a) == 0);
+    CHECK(pool.size() == 0);
+}
+
+TEST_CASE("Testing StableResourcePool - slot reuse and trimming") {
+    const int test_size = 65536;
+    auto pool = StableResourcePool<Obj>(test_size);
+
+    // The most recently freed slot gets reused first
+    std::vector<Ref<Obj>> refs(8);
+    pool.new_items(refs.size(), refs.data(), 0);
+    Obj* freed_addr = refs[5].get_unsafe();
+    pool.release(refs[2]);
+    pool.release(refs[5]);
+    refs[5] = pool.new_item(5);
+    CHECK(refs[5].get_unsafe() == freed_addr);
+    refs[2] = pool.new_item(2);
+
+    // Trimming can't go past live items
+    CHECK(pool.trim() == 0);
+
+    ResourceLabel scene_label = make_res_label("scene");
+    pool.set_resource_label(scene_label);
+    std::vector<Ref<Obj>> scene_refs(20000);
+    pool.new_items(scene_refs.size(), scene_refs.data(), 1);
+    pool.set_resource_label(make_res_label("all"));
+    Ref<Obj> kept = pool.new_item(42);
+    CHECK(pool.release(scene_label) == scene_refs.size());
+    CHECK(pool.trim() == 0);
+
+    pool.release(kept);
+    uint32_t resident_bytes = pool.get_resident_bytes();
+    uint32_t trimmed_bytes = pool.trim();
+    CHECK(trimmed_bytes > 0);
+    CHECK(pool.trim() == 0);
+    // The memory stays committed, but it's no longer resident
+    CHECK(pool.get_resident_bytes() == resident_bytes - trimmed_bytes);
+    CHECK(pool.get_stats().resident_bytes == pool.get_resident_bytes());
+    for (auto ref : scene_refs) {
+        CHECK(!pool.is_valid(ref));
+        CHECK(pool.try_get(ref) == nullptr);
+    }
+
+    // Slots kept after trimming still get reused before growing again
+    for (auto ref : refs) {
+        CHECK(pool.is_valid(ref));
+    }
+    std::vector<Ref<Obj>> new_refs(30000);
+    pool.new_items(new_refs.size(), new_refs.data(), 3);
+    CHECK(pool.size() == refs.size() + new_refs.size());
+    for (auto ref : new_refs) {
+        CHECK(pool.is_valid(ref));
+        CHECK(pool.get(ref)->a == 3);
+    }
+    pool.release_items(new_refs.data(), new_refs.size());
+    CHECK(pool.size() == refs.size());
+}
+
+TEST_CASE("Testing StableResourcePool - trimmed slots keep their generations") {
+    auto pool = StableResourcePool<Obj>(65536);
+    std::vector<Ref<Obj>> refs(20000);
+    pool.new_items(refs.size(), refs.data(), 1);
+    pool.release_items(refs.data(), refs.size());
+    CHECK(pool.trim() > 0);
+
+    // Stale refs into trimmed slots can still be checked
+    for (auto ref : refs) {
+        CHECK(!ref.check());
+        CHECK(!pool.is_valid(ref));
+    }
+
+    // Growing again reuses the trimmed slots, without handing out their old generations
+    std::vector<Ref<Obj>> new_refs(refs.size());
+    pool.new_items(new_refs.size(), new_refs.data(), 2);
+    CHECK(new_refs[0].get_unsafe() == refs[0].get_unsafe());
+    for (auto ref : refs) {
+        CHECK(!ref.check());
+        CHECK(!pool.is_valid(ref));
+    }
+    for (auto ref : new_refs) {
+        CHECK(pool.get(ref)->a == 2);
+    }
+    CHECK(pool.get_stats().free_count == 0);
+}
+
+TEST_CASE("Testing StableResourcePool - stats") {
+    auto pool = StableResourcePool<Obj>(1024);
+    ResourceLabel label_a = make_res_label("a");
+    ResourceLabel label_b = make_res_label("b");
+
+    std::vector<Ref<Obj>> refs(100);
+    pool.set_resource_label(label_a);
+    pool.new_items(60, refs.data(), 0);
+    pool.set_resource_label(label_b);
+    pool.new_items(40, refs.data() + 60, 0);
+    pool.release_items(refs.data() + 10, 20);
+
+    auto stats = pool.get_stats();
+    CHECK(stats.count == 80);
+    CHECK(stats.max_count == 100);
+    CHECK(stats.free_count == 20);
+    CHECK(stats.fragmentation() == doctest::Approx(0.2f));
+    CHECK(stats.committed_bytes >= 100 * sizeof(StableResourcePool<Obj>::Node));
+    CHECK(stats.committed_bytes <= stats.reserved_bytes);
+    std::sort(stats.label_counts.begin(), stats.label_counts.end());
+    std::vector<std::pair<ResourceLabel, uint32_t>> expected = {{label_a, 40}, {label_b, 40}};
+    std::sort(expected.begin(), expected.end());
+    CHECK(stats.label_counts == expected);
+}
+
+TEST_CASE("Testing StableResourcePool - concurrent mode") {
+    const int thread_count = 4;
+    const int items_per_thread = 20000;
+    auto pool = StableResourcePool<Obj>(thread_count * items_per_thread * 2);
+    pool.enable_concurrent();
+
+    // Leave some free slots around, so threads race for both the free list and the growth path
+    std::vector<Ref<Obj>> initial(1000);
+    pool.new_items(initial.size(), initial.data(), 0);
+    pool.release_items(initial.data(), initial.size());
+
+    std::vector<std::vector<Ref<Obj>>> thread_refs(thread_count);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; t++) {
+        threads.emplace_back([&, t]() {
+            auto& refs = thread_refs[t];
+            for (int i = 0; i < items_per_thread; i++) {
+                refs.push_back(pool.new_item(t * items_per_thread + i));
+                // Release every other item again, which only gets queued until sync()
+                if (i % 2 == 1) {
+                    pool.release(refs[refs.size() - 2]);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(pool.size() == thread_count * items_per_thread);
+    pool.sync();
+    CHECK(pool.size() == thread_count * items_per_thread / 2);
+
+    int visited = 0;
+    pool.foreach([&](Obj& obj) { visited++; });
+    CHECK(visited == pool.size());
+
+    for (int t = 0; t < thread_count; t++) {
+        auto& refs = thread_refs[t];
+        for (int i = 0; i < items_per_thread; i++) {
+            if (i % 2 == 0) {
+                CHECK(!pool.is_valid(refs[i]));
+            }
+            else {
+                CHECK(pool.is_valid(refs[i]));
+                CHECK(pool.get(refs[i])->a == t * items_per_thread + i);
+            }
+        }
+    }
+    CHECK(pool.release(make_res_label("all")) == thread_count * items_per_thread / 2);
+    CHECK(pool.size() == 0);
+    // Other threads could be popping the free list, so concurrent pools keep their memory
+    CHECK(pool.trim() == 0);
+}
+
+TEST_CASE("Testing StableResourcePool - handles") {
+    auto pool = StableResourcePool<Obj>(1024);
+    CHECK(sizeof(Handle<Obj>) == 4);
+    CHECK(!pool.is_valid(Handle<Obj>()));
+
+    auto ref = pool.new_item(7);
+    auto handle = pool.get_handle(ref);
+    CHECK(pool.is_valid(handle));
+    CHECK(pool.get(handle)->a == 7);
+    CHECK(pool.get_ref(handle) == ref);
+
+    // Handles survive a round trip through their raw value
+    Handle<Obj> loaded(handle.value);
+    CHECK(loaded == handle);
+    CHECK(pool.try_get(loaded) == ref.get_unsafe());
+
+    pool.release(handle);
+    CHECK(!pool.is_valid(handle));
+    CHECK(pool.try_get(handle) == nullptr);
+    CHECK(!pool.get_ref(handle));
+
+    // The slot gets reused with a new generation, so the old handle stays invalid
+    auto new_ref = pool.new_item(8);
+    auto new_handle = pool.get_handle(new_ref);
+    CHECK(new_handle.index() == handle.index());
+    CHECK(new_handle != handle);
+    CHECK(!pool.is_valid(handle));
+    CHECK(pool.is_valid(new_handle));
+
+}
+
+TEST_CASE("Testing StableResourcePool - slots at the max generation get retired") {
+    auto pool = StableResourcePool<Obj>(1024);
+    auto ref = pool.new_item(0);
+    auto first_handle = pool.get_handle(ref);
+    Handle<Obj> last_handle;
+    // LIFO reuse keeps handing out the same slot, until it runs out of generations
+    for (uint32_t gen = 1; gen < Handle<Obj>::max_generation; gen++) {
+        pool.release(ref);
+        ref = pool.new_item((int)gen);
+        CHECK(pool.get_handle(ref).index() == first_handle.index());
+    }
+    last_handle = pool.get_handle(ref);
+    CHECK(last_handle.generation() == Handle<Obj>::max_generation);
+    CHECK(!pool.is_valid(first_handle));
+
+    pool.release(ref);
+    CHECK(pool.get_stats().retired_count == 1);
+    CHECK(pool.get_stats().free_count == 0);
+
+    // The retired slot is never handed out again, so no old handle or ref can match a new item
+    auto new_ref = pool.new_item(-1);
+    CHECK(pool.get_handle(new_ref).index() != first_handle.index());
+    CHECK(!pool.is_valid(first_handle));
+    CHECK(!pool.is_valid(last_handle));
+    CHECK(!ref.check());
+
+    // Trimming doesn't give it back either
+    pool.release(new_ref);
+    pool.trim();
+    new_ref = pool.new_item(-2);
+    CHECK(pool.get_handle(new_ref).index() != first_handle.index());
+}
+
+TEST_CASE("Testing StableResourcePool - deferred release") {
+    auto pool = StableResourcePool<Obj>(1024);
+    pool.enable_dense_index();
+    std::vector<Ref<Obj>> refs(100);
+    pool.new_items(refs.size(), refs.data(), 0);
+
+    // Releasing while iterating only queues the items
+    int visited = 0;
+    pool.foreach_ref([&](Ref<Obj> ref, Obj& obj) {
+        pool.release_deferred(ref);
+        visited++;
+    });
+    CHECK(visited == refs.size());
+    CHECK(pool.size() == refs.size());
+    for (auto ref : refs) {
+        CHECK(pool.is_valid(ref));
+    }
+
+    // Duplicates and items that got released in the meantime are skipped
+    pool.release_deferred(refs[3]);
+    pool.release(refs[5]);
+    pool.sync();
+    CHECK(pool.size() == 0);
+    for (auto ref : refs) {
+        CHECK(!pool.is_valid(ref));
+    }
+
+    // Freed in slot order, so the lowest slot ends up at the front of the free list
+    auto ref = pool.new_item(1);
+    CHECK(ref.get_unsafe() == refs[0].get_unsafe());
+    pool.sync();
+    CHECK(pool.size() == 1);
+}
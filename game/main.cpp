@@ -15,6 +15,9 @@ public:
         auto resolution = sqvm->get<ivec2>(cfg, "resolution");
         game_width = resolution.x;
         game_height = resolution.y;
+        // 12 byte sprite vertices, only covering +-8192 pixels around the view (sprites past that get clamped)
+        compact_sprite_vertices = sqvm->get_or_default<bool>(cfg, "compact_sprite_vertices", false);
+        instanced_sprites = sqvm->get_or_default<bool>(cfg, "instanced_sprites", false);
 
         scene_name = sqvm->get<std::string>(cfg, "scene");
     }